@@ -13,6 +13,8 @@
 #include "Engine/Core/Time/Clock.hpp"
 #include "Game/GameCommon.hpp"
 #include "Game/GameController.hpp"
+#include "Game/TimerService.hpp"
+#include "Game/FixedStepScheduler.hpp"
 
 //--------------------------------------------------------------------------
 // Global Singletons
@@ -48,6 +50,8 @@ void App::Startup()
 	ClockSystemStartup();
 	m_gameClock = new Clock( &Clock::Master );
 	m_UIClock = new Clock( &Clock::Master );
+	m_gameTimers = new TimerService();
+	m_physicsSteps = new FixedStepScheduler();
 
 	g_theEventSystem->Startup();
 	g_theRenderer->Startup();
@@ -75,6 +79,8 @@ void App::Shutdown()
 
 	SAFE_DELETE( m_gameClock );
 	SAFE_DELETE( m_UIClock );
+	SAFE_DELETE( m_gameTimers );
+	SAFE_DELETE( m_physicsSteps );
 
 	delete g_theGameController;
 	g_theGameController = nullptr;
@@ -278,6 +284,21 @@ bool App::PauseEvent( EventArgs& args )
 	return true;
 }
 
+//--------------------------------------------------------------------------
+/**
+* PhysicsRateEvent
+* physicsrate rate=120 maxSteps=16
+*/
+bool App::PhysicsRateEvent( EventArgs& args )
+{
+	FixedStepScheduler* steps = g_theApp->m_physicsSteps;
+	steps->SetStepRate( args.GetValue( "rate", steps->GetStepRate() ) );
+	steps->SetMaxStepsPerFrame( (uint) args.GetValue( "maxSteps", (int) steps->GetMaxStepsPerFrame() ) );
+	steps->Reset();
+	DebugRenderMessage( 5.0f, Rgba::GREEN, Rgba::WHITE, "Physics: %.1f steps/sec, at most %u per frame", steps->GetStepRate(), steps->GetMaxStepsPerFrame() );
+	return true;
+}
+
 //--------------------------------------------------------------------------
 /**
 * BeginFrame
@@ -302,13 +323,46 @@ void App::BeginFrame()
 */
 void App::Update( float deltaSeconds )
 {
+	m_gameTimers->			Update( deltaSeconds );
 	g_theConsole->			Update();
 	g_theGameController->	Update( deltaSeconds );
-	g_thePhysicsSystem->	Update( deltaSeconds );
+	UpdatePhysics( deltaSeconds );
 	g_theGame->				UpdateGame( deltaSeconds );
 	g_theDebugRenderSystem->Update();
 }
 
+//--------------------------------------------------------------------------
+/**
+* UpdatePhysics
+* Steps physics at a fixed rate, so dilation changes how many steps run rather
+* than how long they are. The map keeps the state from before the frame's
+* last step so rendering can blend from it toward the newest, and sweeps its
+* continuous collision bodies around every step.
+*/
+void App::UpdatePhysics( float deltaSeconds )
+{
+	uint numSteps = m_physicsSteps->Advance( deltaSeconds );
+	float stepSeconds = m_physicsSteps->GetStepSeconds();
+	for( uint stepIdx = 0; stepIdx < numSteps; ++stepIdx )
+	{
+		if( stepIdx == numSteps - 1 )
+		{
+			g_theGame->CapturePrePhysicsState();
+		}
+		g_theGame->BeginPhysicsStep();
+		// PhysicsSystem integrates and solves every body on this thread; solving
+		// independent islands in parallel needs changes inside the engine
+		g_thePhysicsSystem->Update( stepSeconds );
+		g_theGame->EndPhysicsStep( stepSeconds );
+	}
+
+	if( m_physicsSteps->GetDroppedStepsThisFrame() > 0 )
+	{
+		DebugRenderMessage( 0.0f, Rgba::YELLOW, Rgba::WHITE, "Physics fell behind: %u steps dropped (%u total)"
+			, m_physicsSteps->GetDroppedStepsThisFrame(), m_physicsSteps->GetDroppedSteps() );
+	}
+}
+
 //--------------------------------------------------------------------------
 /**
 * Render
@@ -354,5 +408,6 @@ void App::RegisterEvents()
 	g_theEventSystem->SubscribeEventCallbackFunction( "quit", QuitEvent );
 	g_theEventSystem->SubscribeEventCallbackFunction( "pause", PauseEvent );
 	g_theEventSystem->SubscribeEventCallbackFunction( "unpause", UnpauseEvent );
+	g_theEventSystem->SubscribeEventCallbackFunction( "physicsrate", PhysicsRateEvent );
 }
 
@@ -6,6 +6,8 @@
 #include "Game/Game.hpp"
 
 class Clock;
+class TimerService;
+class FixedStepScheduler;
 
 //--------------------------------------------------------------------------
 class App
@@ -30,6 +32,7 @@ public:
 	static bool QuitEvent( EventArgs& args );
 	static bool UnpauseEvent( EventArgs& args );
 	static bool PauseEvent( EventArgs& args );
+	static bool PhysicsRateEvent( EventArgs& args );
 
 	float GetGlobleTime() const { return m_time; }
 	int GetFrameCount() const { return m_frame; }
@@ -38,10 +41,13 @@ public:
 public:
 	Clock* m_gameClock = nullptr;
 	Clock* m_UIClock = nullptr;
+	TimerService* m_gameTimers = nullptr;	// Counts down on m_gameClock
+	FixedStepScheduler* m_physicsSteps = nullptr;	// Physics steps due on m_gameClock
 
 private:
 	void BeginFrame();
 	void Update( float deltaSeconds );
+	void UpdatePhysics( float deltaSeconds );
 	void Render() const;
 	void EndFrame();
 	void RegisterEvents();
@@ -0,0 +1,99 @@
+#include "Game/BackgroundJob.hpp"
+
+//--------------------------------------------------------------------------
+/**
+* ~BackgroundJob
+*/
+BackgroundJob::~BackgroundJob()
+{
+	Join();
+	JoinCanceled( true );
+}
+
+//--------------------------------------------------------------------------
+/**
+* Start
+* Starting again waits for the last run to finish first.
+*/
+void BackgroundJob::Start( std::function<bool()> work )
+{
+	Reset();
+	m_state = std::make_shared<RunState>();
+	m_thread = std::thread( &BackgroundJob::Run, m_state, std::move( work ) );
+}
+
+//--------------------------------------------------------------------------
+/**
+* Join
+*/
+void BackgroundJob::Join()
+{
+	if( m_thread.joinable() )
+	{
+		m_thread.join();
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* Reset
+*/
+void BackgroundJob::Reset()
+{
+	Join();
+	m_state = nullptr;
+	JoinCanceled( false );
+}
+
+//--------------------------------------------------------------------------
+/**
+* Cancel
+* Doesn't wait: the run is left to finish on its own, its result is thrown away,
+* and its thread is joined by a later call once it's done. The job can be started
+* again straight away.
+*/
+void BackgroundJob::Cancel()
+{
+	if( m_thread.joinable() )
+	{
+		m_state->m_canceled.store( true );
+		CanceledRun run;
+		run.m_thread = std::move( m_thread );
+		run.m_state = m_state;
+		m_canceled.push_back( std::move( run ) );
+	}
+	m_state = nullptr;
+	JoinCanceled( false );
+}
+
+//--------------------------------------------------------------------------
+/**
+* JoinCanceled
+* Joins the canceled runs that have finished, or all of them.
+*/
+void BackgroundJob::JoinCanceled( bool waitForAll )
+{
+	for( size_t runIdx = m_canceled.size(); runIdx-- > 0; )
+	{
+		CanceledRun& run = m_canceled[runIdx];
+		if( waitForAll || run.m_state->m_finished.load() )
+		{
+			run.m_thread.join();
+			m_canceled.erase( m_canceled.begin() + runIdx );
+		}
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* Run
+* Worker thread only. A run canceled before its thread got going skips the work.
+*/
+void BackgroundJob::Run( std::shared_ptr<RunState> state, std::function<bool()> work )
+{
+	if( !state->m_canceled.load() )
+	{
+		state->m_succeeded = work();
+	}
+	state->m_finished.store( true );
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+//--------------------------------------------------------------------------
+// Runs one function on its own thread. Only the owner thread touches the job;
+// poll IsFinished() then Join(). Owners declare the job after anything the
+// work writes to, so it is joined before those are destroyed. Work that may be
+// canceled must own what it writes, since it can outlive the run it belonged to.
+//--------------------------------------------------------------------------
+class BackgroundJob
+{
+public:
+	BackgroundJob() {}
+	~BackgroundJob();
+
+public:
+	void Start( std::function<bool()> work );
+	void Join();
+	void Reset();
+	void Cancel();
+
+	bool IsStarted() const		{ return m_state != nullptr; }
+	bool IsFinished() const		{ return m_state && m_state->m_finished.load(); }
+	bool IsRunning() const		{ return IsStarted() && !IsFinished(); }
+	bool Succeeded() const		{ return m_state && m_state->m_succeeded; }
+
+private:
+	struct RunState
+	{
+		std::atomic<bool> m_finished{ false };
+		std::atomic<bool> m_canceled{ false };
+		bool m_succeeded = false;	// Written before m_finished
+	};
+	struct CanceledRun
+	{
+		std::thread m_thread;
+		std::shared_ptr<RunState> m_state;
+	};
+	static void Run( std::shared_ptr<RunState> state, std::function<bool()> work );
+	void JoinCanceled( bool waitForAll );
+
+private:
+	std::thread m_thread;
+	std::shared_ptr<RunState> m_state;
+	std::vector<CanceledRun> m_canceled;	// Joined once they finish
+};
@@ -0,0 +1,79 @@
+#include "Game/FixedStepScheduler.hpp"
+#include <algorithm>
+#include <math.h>
+
+//--------------------------------------------------------------------------
+/**
+* FixedStepScheduler
+*/
+FixedStepScheduler::FixedStepScheduler( float stepsPerSecond, uint maxStepsPerFrame )
+{
+	SetStepRate( stepsPerSecond );
+	SetMaxStepsPerFrame( maxStepsPerFrame );
+}
+
+//--------------------------------------------------------------------------
+/**
+* Advance
+* Adds the frame's time and returns how many steps are due now.
+*/
+uint FixedStepScheduler::Advance( double deltaSeconds )
+{
+	m_accumulator += std::max( deltaSeconds, 0.0 );
+	// Rounding can leave the accumulator a hair below zero
+	double dueSteps = std::max( floor( m_accumulator / m_stepSeconds ), 0.0 );
+	m_droppedThisFrame = 0;
+	if( dueSteps > (double) m_maxStepsPerFrame )
+	{
+		// Keep the partial step so interpolation stays smooth through a hitch
+		m_droppedThisFrame = (uint) std::min( dueSteps - (double) m_maxStepsPerFrame, 4294967295.0 );
+		m_droppedSteps += std::min( m_droppedThisFrame, 0xffffffffu - m_droppedSteps );
+		m_accumulator -= ( dueSteps - (double) m_maxStepsPerFrame ) * m_stepSeconds;
+		dueSteps = (double) m_maxStepsPerFrame;
+	}
+
+	m_stepsThisFrame = (uint) dueSteps;
+	m_accumulator -= dueSteps * m_stepSeconds;
+	return m_stepsThisFrame;
+}
+
+//--------------------------------------------------------------------------
+/**
+* Reset
+*/
+void FixedStepScheduler::Reset()
+{
+	m_accumulator = 0.0;
+	m_stepsThisFrame = 0;
+	m_droppedThisFrame = 0;
+	m_droppedSteps = 0;
+}
+
+//--------------------------------------------------------------------------
+/**
+* SetStepRate
+* Takes effect on the next Advance; time already owed is kept.
+*/
+void FixedStepScheduler::SetStepRate( float stepsPerSecond )
+{
+	m_stepSeconds = 1.0 / (double) std::max( stepsPerSecond, 1.0f );
+}
+
+//--------------------------------------------------------------------------
+/**
+* SetMaxStepsPerFrame
+*/
+void FixedStepScheduler::SetMaxStepsPerFrame( uint maxSteps )
+{
+	m_maxStepsPerFrame = std::max( maxSteps, 1u );
+}
+
+//--------------------------------------------------------------------------
+/**
+* GetInterpolation
+* How far time has got from the last step toward the next, 0 to 1.
+*/
+float FixedStepScheduler::GetInterpolation() const
+{
+	return (float) std::min( std::max( m_accumulator / m_stepSeconds, 0.0 ), 1.0 );
+}
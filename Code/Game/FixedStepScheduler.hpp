@@ -0,0 +1,35 @@
+#pragma once
+#include "Engine/Core/EngineCommon.hpp"
+
+//--------------------------------------------------------------------------
+// Turns variable frame times into a whole number of fixed steps. Time that
+// doesn't make up a full step carries over to the next frame; frames that
+// owe more than the step limit drop the excess rather than spiral.
+//--------------------------------------------------------------------------
+class FixedStepScheduler
+{
+public:
+	explicit FixedStepScheduler( float stepsPerSecond = 120.0f, uint maxStepsPerFrame = 16 );
+
+	uint Advance( double deltaSeconds );
+	void Reset();
+
+	void SetStepRate( float stepsPerSecond );
+	void SetMaxStepsPerFrame( uint maxSteps );
+
+	float GetStepRate() const						{ return (float) ( 1.0 / m_stepSeconds ); }
+	float GetStepSeconds() const					{ return (float) m_stepSeconds; }
+	uint GetMaxStepsPerFrame() const				{ return m_maxStepsPerFrame; }
+	uint GetStepsThisFrame() const					{ return m_stepsThisFrame; }
+	uint GetDroppedStepsThisFrame() const			{ return m_droppedThisFrame; }
+	uint GetDroppedSteps() const					{ return m_droppedSteps; }
+	float GetInterpolation() const;
+
+private:
+	double m_stepSeconds;
+	double m_accumulator		= 0.0;
+	uint m_maxStepsPerFrame;
+	uint m_stepsThisFrame		= 0;
+	uint m_droppedThisFrame		= 0;
+	uint m_droppedSteps			= 0;	// Since the last Reset
+};
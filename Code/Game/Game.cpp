@@ -23,6 +23,8 @@
 #include "Engine/Renderer/Debug/DebugRenderSystem.hpp"
 #include "Engine/Core/Vertex/Vertex_LIT.hpp"
 #include "Game/Map.hpp"
+#include "Game/MapLoadJob.hpp"
+#include "Game/MapSaveJob.hpp"
 #include "Game/GameController.hpp"
 #include "Engine/Renderer/Model.hpp"
 #include "Engine/Renderer/Shaders/UniformBuffer.hpp"
@@ -77,6 +79,7 @@ void Game::Startup()
 
 	m_fadeinStopwatch = new StopWatch( g_theApp->m_UIClock );
 	m_fadeoutStopwatch = new StopWatch( g_theApp->m_UIClock );
+	m_saveJob = new MapSaveJob();
 }
 
 //--------------------------------------------------------------------------
@@ -91,6 +94,12 @@ void Game::Shutdown()
 	SAFE_DELETE(m_pauseMenuRadGroup);
 	SAFE_DELETE(m_fadeinStopwatch);
 	SAFE_DELETE(m_fadeoutStopwatch);
+	for( MapLoadJob* job : m_loadTestJobs )
+	{
+		delete job;
+	}
+	m_loadTestJobs.clear();
+	SAFE_DELETE(m_saveJob);
 	for( Map* map : m_maps )
 	{
 		delete map;
@@ -350,6 +359,9 @@ void Game::UpdateGame( float deltaSeconds )
 		DeleteShape();
 	}
 
+	UpdateLoadTest();
+	UpdateSaveJob();
+
 	float screenHeight = g_theDebugRenderSystem->GetScreenHeight() * .5f;
 	float screenWidth = g_theDebugRenderSystem->GetScreenWidth() * .5f;
 	Matrix44 camModle = m_curCamera->GetModelMatrix();
@@ -364,7 +376,7 @@ void Game::UpdateGame( float deltaSeconds )
 /**
 * GetCurrentMap
 */
-Map* Game::GetCurrentMap()
+Map* Game::GetCurrentMap() const
 {
 	if( GAMESTATE_GAMEPLAY == m_state || GAMESTATE_EDITOR == m_state )
 	{
@@ -373,123 +385,121 @@ Map* Game::GetCurrentMap()
 	return nullptr;
 }
 
+//--------------------------------------------------------------------------
+/**
+* CapturePrePhysicsState
+* Called before the frame's last physics step.
+*/
+void Game::CapturePrePhysicsState()
+{
+	Map* map = GetCurrentMap();
+	if( map )
+	{
+		map->CapturePreviousShapeState();
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* BeginPhysicsStep
+*/
+void Game::BeginPhysicsStep()
+{
+	Map* map = GetCurrentMap();
+	if( map )
+	{
+		map->BeginPhysicsStep();
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* EndPhysicsStep
+*/
+void Game::EndPhysicsStep( float stepSeconds )
+{
+	Map* map = GetCurrentMap();
+	if( map )
+	{
+		map->EndPhysicsStep( stepSeconds );
+	}
+}
+
 //--------------------------------------------------------------------------
 /**
 * SelectShape
+* Cycles to the next shape, or picks the one closest to the cursor if nothing is selected.
 */
 void Game::SelectShape()
 {
-	if( GetCurrentMap()->GetNumShapes() == 0 )
+	Map* map = GetCurrentMap();
+	if( map->GetNumShapes() == 0 )
 	{
 		return;
 	}
-	if( m_selectedShape )
+	if( GetSelectedShape() )
 	{
-		// Find where to start searching for next.
-		int newIndex = 0;
-		for( int shapeIndex = 0; shapeIndex < (int) GetCurrentMap()->m_shapes.size(); ++shapeIndex )
-		{
-			if( m_selectedShape == GetCurrentMap()->m_shapes[shapeIndex] )
-			{
-				newIndex = ++shapeIndex;
-				break;
-			}
-
-		}
-
-		// Don't go out of bounds
-		if( newIndex >= (int) GetCurrentMap()->m_shapes.size() )
-		{
-			newIndex = 0;
-		}
-
-		// Find next item to select
-		int toSelectIndex = newIndex;
-		int counter = 300;
-		while ( !GetCurrentMap()->m_shapes[toSelectIndex] )
-		{
-			toSelectIndex++;
-			counter--;
-			if( toSelectIndex >= (int) GetCurrentMap()->m_shapes.size() )
-			{
-				toSelectIndex = 0;
-			}
-			if( counter == 0 )
-			{
-				break;
-			}
-		}
-
-		// Only select if found one that exists.
-		if( GetCurrentMap()->m_shapes[toSelectIndex] )
+		uint nextIdx = map->m_shapes.GetDenseIndex( m_selectedShape ) + 1;
+		if( nextIdx >= map->GetNumShapes() )
 		{
-			DeselectShape();
-			m_selectedShape = GetCurrentMap()->m_shapes[toSelectIndex];
-			m_selectedShape->m_selected = true;
-			m_selectedShape->m_rigidbody->SetSimulationType( ePhysicsSimulationType::PHYSICS_SIM_STATIC );
-			m_cursor->m_trasform.m_position = m_selectedShape->GetPosition();
-
-			m_xRestrcted	= m_selectedShape->m_rigidbody->IsXRestricted();
-			m_yRestrcted	= m_selectedShape->m_rigidbody->IsYRestricted();
-			m_rotRestrcted	= m_selectedShape->m_rigidbody->IsRotRestricted();
-
-			m_angularVel = m_selectedShape->m_rigidbody->GetAngularVelocity();
-			// 			m_restitution	= m_selectedShape->m_rigidbody->GetRestitution();
-			// 			m_friction		= m_selectedShape->m_rigidbody->GetFriction();
-			// 			m_mass			= m_selectedShape->m_rigidbody->GetMass();
-			// 			m_angularDrag	= m_selectedShape->m_rigidbody->GetAngularDrag();
-			// 			m_drag			= m_selectedShape->m_rigidbody->GetDrag();
+			nextIdx = 0;
 		}
+		SetSelectedShape( map->m_shapes[nextIdx] );
 	}
 	else
 	{
-		Shape* closestShape = nullptr;
-		float closestDistance = 999999999999.0f;
-		for( int shapeIndex = 0; shapeIndex < (int)  GetCurrentMap()->m_shapes.size(); ++shapeIndex )
-		{
-			if(  GetCurrentMap()->m_shapes[shapeIndex] )
-			{
-				Shape* testShape =  GetCurrentMap()->m_shapes[shapeIndex];
-				float testDist = ( m_cursor->m_trasform.m_position - testShape->GetPosition() ).GetLengthSquared();
-				if( testDist < closestDistance )
-				{
-					closestDistance = testDist;
-					closestShape = testShape;
-				}
-			}
-		}
+		Shape* closestShape = map->QueryNearest( m_cursor->m_trasform.m_position );
 		// Only select if found one that exists.
 		if( closestShape )
 		{
-			m_selectedShape = closestShape;
-			m_selectedShape->m_selected = true;
-			m_selectedShape->m_rigidbody->SetSimulationType( ePhysicsSimulationType::PHYSICS_SIM_STATIC );
-			m_cursor->m_trasform.m_position = m_selectedShape->GetPosition();
-
-			m_xRestrcted	= m_selectedShape->m_rigidbody->IsXRestricted();
-			m_yRestrcted	= m_selectedShape->m_rigidbody->IsYRestricted();
-			m_rotRestrcted	= m_selectedShape->m_rigidbody->IsRotRestricted();
-
-			m_angularVel = m_selectedShape->m_rigidbody->GetAngularVelocity();
-
-			// 			m_restitution	= m_selectedShape->m_rigidbody->GetRestitution();
-			// 			m_friction		= m_selectedShape->m_rigidbody->GetFriction();
-			// 			m_mass			= m_selectedShape->m_rigidbody->GetMass();
-			// 			m_angularDrag	= m_selectedShape->m_rigidbody->GetAngularDrag();
-			// 			m_drag			= m_selectedShape->m_rigidbody->GetDrag();
+			SetSelectedShape( closestShape );
 		}
 	}
 }
 
+//--------------------------------------------------------------------------
+/**
+* SetSelectedShape
+*/
+void Game::SetSelectedShape( Shape* shape )
+{
+	DeselectShape();
+	m_selectedShape = shape->m_handle;
+	GetCurrentMap()->SetShapeFlag( m_selectedShape, SHAPE_FLAG_SELECTED, true );
+	shape->m_rigidbody->SetSimulationType( ePhysicsSimulationType::PHYSICS_SIM_STATIC );
+	m_cursor->m_trasform.m_position = shape->GetPosition();
+
+	m_xRestrcted	= shape->m_rigidbody->IsXRestricted();
+	m_yRestrcted	= shape->m_rigidbody->IsYRestricted();
+	m_rotRestrcted	= shape->m_rigidbody->IsRotRestricted();
+
+	m_angularVel = shape->m_rigidbody->GetAngularVelocity();
+	// 			m_restitution	= shape->m_rigidbody->GetRestitution();
+	// 			m_friction		= shape->m_rigidbody->GetFriction();
+	// 			m_mass			= shape->m_rigidbody->GetMass();
+	// 			m_angularDrag	= shape->m_rigidbody->GetAngularDrag();
+	// 			m_drag			= shape->m_rigidbody->GetDrag();
+}
+
+//--------------------------------------------------------------------------
+/**
+* GetSelectedShape
+* nullptr once the selected shape has been destroyed.
+*/
+Shape* Game::GetSelectedShape()
+{
+	Map* map = GetCurrentMap();
+	return map ? map->GetShape( m_selectedShape ) : nullptr;
+}
+
 //--------------------------------------------------------------------------
 /**
 * IsHovering
 */
 bool Game::IsHovering( Shape* shape ) const
 {
-	Collision2D collisionInfo;
-	DiscCollider2D cursorCollider( m_cursor->m_trasform.m_position, m_cursor->m_disc.m_radius );
-	return shape->m_collider->IsTouching( &cursorCollider, &collisionInfo );
+	Map* map = GetCurrentMap();
+	return map && map->GetDistanceToShape( shape->m_handle, m_cursor->m_trasform.m_position ) <= m_cursor->m_disc.m_radius;
 }
 
 //--------------------------------------------------------------------------
@@ -498,12 +508,13 @@ bool Game::IsHovering( Shape* shape ) const
 */
 void Game::DeselectShape()
 {
-	if( m_selectedShape )
+	Shape* selectedShape = GetSelectedShape();
+	if( selectedShape )
 	{
-		m_selectedShape->m_rigidbody->ResetSimulationType();
-		m_selectedShape->m_selected = false;
-		m_selectedShape = nullptr;
+		selectedShape->m_rigidbody->ResetSimulationType();
+		GetCurrentMap()->SetShapeFlag( m_selectedShape, SHAPE_FLAG_SELECTED, false );
 	}
+	m_selectedShape = ShapeHandle::INVALID;
 }
 
 //--------------------------------------------------------------------------
@@ -512,11 +523,12 @@ void Game::DeselectShape()
 */
 void Game::DeleteShape()
 {
-	if( m_selectedShape )
+	Shape* selectedShape = GetSelectedShape();
+	if( selectedShape )
 	{
-		m_selectedShape->m_isGarbage = true;
-		m_selectedShape = nullptr;
+		GetCurrentMap()->QueueDestroy( m_selectedShape );
 	}
+	m_selectedShape = ShapeHandle::INVALID;
 	m_deletingSelected = false;
 }
 
@@ -545,7 +557,7 @@ void Game::EndShapeConstruction()
 		m_constEnd =  m_cursor->m_trasform.m_position;
 		Vec2 disp = m_constEnd - m_constStart;
 		Transform2D trans( m_constStart + disp * 0.5f, disp.GetAngleDegrees() );
-		Shape* shape = new Pill( trans , m_spawnDynamic ? PHYSICS_SIM_DYNAMIC : PHYSICS_SIM_STATIC, m_curAlignment, disp.GetLength(), m_curThickness, m_curRadius, m_mass, m_restitution, m_friction, m_drag, m_angularDrag );
+		Shape* shape = m_maps[m_curMapIdx]->m_pillPool.Create( trans , m_spawnDynamic ? PHYSICS_SIM_DYNAMIC : PHYSICS_SIM_STATIC, m_curAlignment, disp.GetLength(), m_curThickness, m_curRadius, m_mass, m_restitution, m_friction, m_drag, m_angularDrag );
 		shape->m_rigidbody->SetRestrictions( m_xRestrcted, m_yRestrcted, m_rotRestrcted );
 		shape->m_rigidbody->SetAngularVelocity( m_angularVel );
 		m_maps[m_curMapIdx]->AddShape( shape );
@@ -587,7 +599,7 @@ void Game::SetEnd()
 {
 	if( m_state == GAMESTATE_EDITOR )	
 	{
-		m_maps[0]->m_endZone = Vec2( g_theGameController->GetWorldMousePos() );
+		m_maps[0]->SetEndZone( Vec2( g_theGameController->GetWorldMousePos() ) );
 	}
 }
 
@@ -667,6 +679,14 @@ void Game::RenderLoadingScreen() const
 	textchild->m_text = "Loading";
 	textchild->m_color = Rgba::WHITE;
 
+	// Keep something moving while the map loads in the background
+	int numDots = (int) ( m_gameTime * 3.0f ) % 4;
+	textchild->m_text.append( (size_t) numDots, '.' );
+	if( m_state == GAMESTATE_LOADING && m_curMapIdx < (uint) m_maps.size() && m_maps[m_curMapIdx]->IsLoadingAsync() )
+	{
+		textchild->m_text += Stringf( " %d%%", (int) ( m_maps[m_curMapIdx]->GetLoadProgress() * 100.0f ) );
+	}
+
 	canvas.UpdateBounds( AABB2( SCREEN_WIDTH, SCREEN_HEIGHT ) );
 	canvas.Render();
 }
@@ -760,7 +780,7 @@ void Game::RenderPauseMenu() const
 void Game::DrawEditorValues()
 {
 	DebugRenderMessage( 0.0f, Rgba::WHITE, Rgba::WHITE, Stringf( "Set EndPos [5]" ).c_str() );
-	DebugRenderMessage( 0.0f, Rgba::WHITE, Rgba::WHITE, Stringf( "Number of Objects:	   %d", GetCurrentMap()->m_shapes.size() ).c_str() );
+	DebugRenderMessage( 0.0f, Rgba::WHITE, Rgba::WHITE, Stringf( "Number of Objects:	   %d", GetCurrentMap()->GetNumShapes() ).c_str() );
 	DebugRenderMessage( 0.0f, Rgba::WHITE, Rgba::WHITE, Stringf( "Objects Mass[n,m]:       %.2f", m_mass ).c_str() );
 	DebugRenderMessage( 0.0f, Rgba::WHITE, Rgba::WHITE, Stringf( "Objects Restitution[<,>]:%.2f", m_restitution ).c_str() );
 	DebugRenderMessage( 0.0f, Rgba::WHITE, Rgba::WHITE, Stringf( "Objects Friction[V,B]:   %.2f", m_friction ).c_str() );
@@ -1031,6 +1051,7 @@ void Game::UpdateMap( float deltaSec, unsigned int index )
 		FadeIn();
 	}
 	ASSERT_OR_DIE( index < m_maps.size() && index >= 0, Stringf( "Invalid index of: %u into the maps.", index ) );
+	PrefetchNextMap();
 	m_maps[index]->Update( deltaSec );
 }
 
@@ -1049,12 +1070,20 @@ void Game::UpdateEditor( float deltaSec )
 		UpdateEditorUI( deltaSec );
 	}
 
-	if( m_selectedShape && m_selectedShape->IsAlive() )
+	Shape* selectedShape = GetSelectedShape();
+	if( selectedShape && selectedShape->IsAlive() )
 	{
-		m_selectedShape->m_rigidbody->SetMass( m_mass );
-		m_selectedShape->m_rigidbody->SetPhyMaterial( m_restitution, m_friction, m_drag, m_angularDrag );
-		m_selectedShape->m_rigidbody->SetRestrictions( m_xRestrcted, m_yRestrcted, m_rotRestrcted );
-		m_selectedShape->m_rigidbody->SetAngularVelocity( m_angularVel );
+		selectedShape->m_rigidbody->SetMass( m_mass );
+		selectedShape->m_rigidbody->SetPhyMaterial( m_restitution, m_friction, m_drag, m_angularDrag );
+		selectedShape->m_rigidbody->SetRestrictions( m_xRestrcted, m_yRestrcted, m_rotRestrcted );
+		selectedShape->m_rigidbody->SetAngularVelocity( m_angularVel );
+
+		ShapeDefinition& def = selectedShape->m_definition;
+		def.m_mass			= m_mass;
+		def.m_restitution	= m_restitution;
+		def.m_friction		= m_friction;
+		def.m_drag			= m_drag;
+		def.m_angularDrag	= m_angularDrag;
 	}
 
 	
@@ -1185,6 +1214,8 @@ void Game::InisializeGame()
 	g_theEventSystem->SubscribeEventCallbackFunction( "play", LoadToLevel );
 	g_theEventSystem->SubscribeEventCallbackFunction( "save", Save );
 	g_theEventSystem->SubscribeEventCallbackFunction( "load", LoadMap );
+	g_theEventSystem->SubscribeEventCallbackFunction( "deterministic", DeterministicEvent );
+	RegisterDebugCommands();
 
 
 	for( uint mapIdx = 0; mapIdx < m_numLevels + 1; ++mapIdx )
@@ -1215,17 +1246,32 @@ void Game::LoadLevel( unsigned int index )
 	}
 	m_curMapIdx = index;
 	ASSERT_OR_DIE( (unsigned int) m_maps.size() > index, "Bad level index" );
-	
-	for( Map* m : m_maps )
+	Map* map = m_maps[index];
+
+	// Read on a worker (or reuse the prefetch), then spawn a slice of the shapes each frame until done
+	if( m_stateFrameCount == 2 )
 	{
-		m->DeleteAllShapes();
+		bool usePrefetch = m_prefetchMapIdx == (int) index;
+		m_prefetchMapIdx = -1;
+		m_saveJob->Join();
+		for( Map* m : m_maps )
+		{
+			if( m != map || !usePrefetch )
+			{
+				m->CancelLoadAsync();
+			}
+			m->DeleteAllShapes();
+		}
+		if( !usePrefetch )
+		{
+			map->BeginLoadAsync( Stringf( "Data/Saved/map%u.map", index ).c_str() );
+		}
 	}
 
-	if( !m_maps[index]->IsLoaded() )
+	if( map->UpdateLoadAsync() )
 	{
-		m_maps[index]->Load( Stringf("Data/Saved/map%u.map", index ).c_str() );
+		SwitchStates( m_curMapIdx == 0 ? GAMESTATE_EDITOR : GAMESTATE_GAMEPLAY );
 	}
-	SwitchStates( m_curMapIdx == 0 ? GAMESTATE_EDITOR : GAMESTATE_GAMEPLAY );
 }
 
 //--------------------------------------------------------------------------
@@ -1243,6 +1289,41 @@ void Game::LoadNextMap()
 	HandleQuitRequest();
 }
 
+//--------------------------------------------------------------------------
+/**
+* PrefetchNextMap
+* Starts reading the level after the current one so LoadNextMap only has to spawn it.
+*/
+void Game::PrefetchNextMap()
+{
+	uint nextIdx = m_curMapIdx + 1;
+	if( m_curMapIdx == 0 || nextIdx >= (uint) m_maps.size() || m_prefetchMapIdx == (int) nextIdx )
+	{
+		return;
+	}
+	// Don't read a file that may still be half written
+	if( m_saveJob->IsRunning() )
+	{
+		return;
+	}
+	CancelPrefetch();
+	m_maps[nextIdx]->BeginLoadAsync( Stringf( "Data/Saved/map%u.map", nextIdx ).c_str() );
+	m_prefetchMapIdx = (int) nextIdx;
+}
+
+//--------------------------------------------------------------------------
+/**
+* CancelPrefetch
+*/
+void Game::CancelPrefetch()
+{
+	if( m_prefetchMapIdx >= 0 )
+	{
+		m_maps[m_prefetchMapIdx]->CancelLoadAsync();
+		m_prefetchMapIdx = -1;
+	}
+}
+
 //--------------------------------------------------------------------------
 /**
 * LoadToLevel
@@ -1250,6 +1331,7 @@ void Game::LoadNextMap()
 bool Game::LoadToLevel( EventArgs& args )
 {
 	int level = args.GetValue( "level", 0 );
+	g_theGame->CancelPrefetch();
 	g_theGame->SwitchStates( GAMESTATE_LOADING );
 	g_theGame->m_curMapIdx = level;
 	return true;
@@ -1264,6 +1346,8 @@ bool Game::LoadMap( EventArgs& args )
 	std::string fileName = args.GetValue( "fileName", "COULD_NOT_FIND_FILENAME" );
 	std::string filePath = Stringf( "Data/Saved/%s.map", fileName.c_str() );
 
+	g_theGame->CancelPrefetch();
+	g_theGame->m_saveJob->Join();
 	return g_theGame->GetCurrentMap()->Load( filePath.c_str() );
 }
 
@@ -1281,7 +1365,25 @@ bool Game::Save( EventArgs& args )
 		return false;
 	}
 
-	return g_theGame->GetCurrentMap()->Save( filePath.c_str() );
+	// The file we write may be the one being prefetched
+	g_theGame->CancelPrefetch();
+	g_theGame->GetCurrentMap()->SaveAsync( filePath.c_str(), *g_theGame->m_saveJob );
+	return true;
+}
+
+//--------------------------------------------------------------------------
+/**
+* UpdateSaveJob
+*/
+void Game::UpdateSaveJob()
+{
+	if( m_saveJob->IsStarted() && m_saveJob->IsFinished() )
+	{
+		m_saveJob->Join();
+		DebugRenderMessage( 5.0f, m_saveJob->Succeeded() ? Rgba::GREEN : Rgba::RED, Rgba::WHITE, "Saved %s: %u shapes"
+			, m_saveJob->GetFilename().c_str(), (uint) m_saveJob->GetData().m_shapes.size() );
+		m_saveJob->Reset();
+	}
 }
 
 //--------------------------------------------------------------------------
@@ -1396,3 +1498,19 @@ void Game::RenderFade() const
 	}
 	
 }
+
+//--------------------------------------------------------------------------
+/**
+* DeterministicEvent
+* deterministic enabled=1
+*/
+bool Game::DeterministicEvent( EventArgs& args )
+{
+	bool isDeterministic = args.GetValue( "enabled", 1 ) != 0;
+	for( Map* map: g_theGame->m_maps )
+	{
+		map->SetDeterministic( isDeterministic );
+	}
+	DebugRenderMessage( 5.0f, Rgba::GREEN, Rgba::WHITE, "Deterministic physics %s", isDeterministic ? "on" : "off" );
+	return true;
+}
@@ -3,6 +3,7 @@
 #include "Engine/Core/EventSystem.hpp"
 #include "Engine/Renderer/Camera.hpp"
 #include "Game/UIWidget.hpp"
+#include "Game/Shapes/ShapeSlotMap.hpp"
 #include "Engine/Math/Matrix44.hpp"
 #include "Engine/Math/Vec3.hpp"
 
@@ -15,6 +16,8 @@ class StopWatch;
 class UniformBuffer;
 class Cursor;
 class Shape;
+class MapLoadJob;
+class MapSaveJob;
 
 struct singleEffect
 {
@@ -51,10 +54,15 @@ public:
 
 public:
 	// Gameplay
-	Map* GetCurrentMap();
+	Map* GetCurrentMap() const;
+	void CapturePrePhysicsState();
+	void BeginPhysicsStep();
+	void EndPhysicsStep( float stepSeconds );
 
 	// Editor
 	void SelectShape();
+	void SetSelectedShape( Shape* shape );
+	Shape* GetSelectedShape();
 	bool IsHovering( Shape* shape ) const;
 	void DeselectShape();
 	void DeleteShape();
@@ -97,11 +105,36 @@ private:
 	void InisializeGame();
 	void LoadLevel( unsigned int index );
 	void LoadNextMap();
+	void PrefetchNextMap();
+	void CancelPrefetch();
 
 private:
 	static bool LoadToLevel( EventArgs& args );
 	static bool LoadMap( EventArgs& args );
 	static bool Save( EventArgs& args );
+	static bool DeterministicEvent( EventArgs& args );
+
+private:
+	void UpdateSaveJob();
+
+private:
+	// Dev console tests and benchmarks, in GameDebugCommands.cpp
+	void RegisterDebugCommands();
+	void UpdateLoadTest();
+	static bool PhysicsStatsEvent( EventArgs& args );
+	static bool LoadTest( EventArgs& args );
+	static bool RespawnBenchmark( EventArgs& args );
+	static bool SaveRoundTripTest( EventArgs& args );
+	static bool PoolBenchmark( EventArgs& args );
+	static bool ReloadSoakTest( EventArgs& args );
+	static bool ShapeFrameBenchmark( EventArgs& args );
+	static bool QueryBenchmark( EventArgs& args );
+	static bool SpawnBenchmark( EventArgs& args );
+	static bool TriggerBenchmark( EventArgs& args );
+	static bool BroadphaseBenchmark( EventArgs& args );
+	static bool NarrowphaseTest( EventArgs& args );
+	static bool SleepBenchmark( EventArgs& args );
+	static bool DeterminismTest( EventArgs& args );
 
 private:
 	void UpdateStates();
@@ -137,7 +170,7 @@ private:
 		Vec2 m_constStart = Vec2::ZERO;
 		Vec2 m_constEnd = Vec2::ZERO;
 		bool m_constructing  = false;
-		Shape* m_selectedShape = nullptr;
+		ShapeHandle m_selectedShape;
 		Cursor* m_cursor;
 
 
@@ -151,6 +184,9 @@ private:
 	unsigned int  m_curMapIdx = 1;
 	bool		  m_toNextLevel = false;
 	std::vector<Map*> m_maps;
+	std::vector<MapLoadJob*> m_loadTestJobs;
+	MapSaveJob*	  m_saveJob = nullptr;
+	int			  m_prefetchMapIdx = -1;
 
 private:
 	unsigned int m_stateFrameCount = 0;
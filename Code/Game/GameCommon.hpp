@@ -33,11 +33,6 @@ extern GameController* g_theGameController;
 //--------------------------------------------------------------------------
 // Constant global variables.
 //--------------------------------------------------------------------------
-constexpr float WORLD_WIDTH = 10.f;
-constexpr float WORLD_HEIGHT = 5.f;
-constexpr float WORLD_CENTER_X = WORLD_WIDTH / 2.f;
-constexpr float WORLD_CENTER_Y = WORLD_HEIGHT / 2.f;
-
 constexpr float SCREEN_WIDTH = 200.0f;
 constexpr float SCREEN_HEIGHT = 100.0f;
 constexpr float SCREEN_HALF_WIDTH = 200.0f * .5f;
@@ -0,0 +1,1110 @@
+#include "Game/Game.hpp"
+#include "Game/GameCommon.hpp"
+#include "Game/App.hpp"
+#include "Game/Map.hpp"
+#include "Game/MapFormat.hpp"
+#include "Game/MapLoadJob.hpp"
+#include "Game/MapSaveJob.hpp"
+#include "Game/TimerService.hpp"
+#include "Game/TriggerField.hpp"
+#include "Game/FixedStepScheduler.hpp"
+#include "Game/Shapes/Shape.hpp"
+#include "Game/Shapes/Pill.hpp"
+#include "Game/Shapes/PillPool.hpp"
+#include "Game/Shapes/PillboxMath.hpp"
+#include "Engine/Core/EventSystem.hpp"
+#include "Engine/Core/Time/Time.hpp"
+#include "Engine/Renderer/Debug/DebugRenderSystem.hpp"
+#include "Engine/Physics/Rigidbody2D.hpp"
+#include "Engine/Physics/PillboxCollider2D.hpp"
+#include <vector>
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+//--------------------------------------------------------------------------
+/**
+* RegisterDebugCommands
+* Console commands that check and time the map code; see the functions below.
+*/
+void Game::RegisterDebugCommands()
+{
+	g_theEventSystem->SubscribeEventCallbackFunction( "physicsstats", PhysicsStatsEvent );
+	g_theEventSystem->SubscribeEventCallbackFunction( "loadtest", LoadTest );
+	g_theEventSystem->SubscribeEventCallbackFunction( "respawnbench", RespawnBenchmark );
+	g_theEventSystem->SubscribeEventCallbackFunction( "savetest", SaveRoundTripTest );
+	g_theEventSystem->SubscribeEventCallbackFunction( "poolbench", PoolBenchmark );
+	g_theEventSystem->SubscribeEventCallbackFunction( "soaktest", ReloadSoakTest );
+	g_theEventSystem->SubscribeEventCallbackFunction( "shapebench", ShapeFrameBenchmark );
+	g_theEventSystem->SubscribeEventCallbackFunction( "querybench", QueryBenchmark );
+	g_theEventSystem->SubscribeEventCallbackFunction( "spawnbench", SpawnBenchmark );
+	g_theEventSystem->SubscribeEventCallbackFunction( "triggerbench", TriggerBenchmark );
+	g_theEventSystem->SubscribeEventCallbackFunction( "broadphasebench", BroadphaseBenchmark );
+	g_theEventSystem->SubscribeEventCallbackFunction( "narrowphasetest", NarrowphaseTest );
+	g_theEventSystem->SubscribeEventCallbackFunction( "sleepbench", SleepBenchmark );
+	g_theEventSystem->SubscribeEventCallbackFunction( "determinismtest", DeterminismTest );
+}
+
+//--------------------------------------------------------------------------
+/**
+* PhysicsStatsEvent
+* Shows the maps' per-frame physics and streaming counters.
+* physicsstats enabled=1
+*/
+bool Game::PhysicsStatsEvent( EventArgs& args )
+{
+	bool isShowingStats = args.GetValue( "enabled", 1 ) != 0;
+	for( Map* map: g_theGame->m_maps )
+	{
+		map->SetShowingStats( isShowingStats );
+	}
+	DebugRenderMessage( 5.0f, Rgba::GREEN, Rgba::WHITE, "Physics stats %s", isShowingStats ? "on" : "off" );
+	return true;
+}
+
+//--------------------------------------------------------------------------
+/**
+* LoadTest
+* Reads every .map in Data/Saved on workers; results are reported as they finish
+* while the frame loop keeps running.
+*/
+bool Game::LoadTest( EventArgs& args )
+{
+	UNUSED( args );
+
+	// Don't read a file that may still be half written
+	g_theGame->m_saveJob->Join();
+	std::vector<std::string> files = GetFilesInFolder( "Data/Saved", ".map" );
+	for( const std::string& file : files )
+	{
+		MapLoadJob* job = new MapLoadJob();
+		job->Start( file );
+		g_theGame->m_loadTestJobs.push_back( job );
+	}
+	return !files.empty();
+}
+
+//--------------------------------------------------------------------------
+/**
+* RespawnBenchmark
+* Times reloading the current map from file against restoring its snapshot.
+*/
+bool Game::RespawnBenchmark( EventArgs& args )
+{
+	Map* map = g_theGame->GetCurrentMap();
+	if( !map || map->m_filename.empty() )
+	{
+		return false;
+	}
+	int count = args.GetValue( "count", 100 );
+	std::string filename = map->m_filename;
+
+	double startTime = GetCurrentTimeSeconds();
+	for( int runIdx = 0; runIdx < count; ++runIdx )
+	{
+		map->Load( filename.c_str() );
+	}
+	double reloadTime = GetCurrentTimeSeconds() - startTime;
+
+	startTime = GetCurrentTimeSeconds();
+	for( int runIdx = 0; runIdx < count; ++runIdx )
+	{
+		map->Respawn();
+	}
+	double respawnTime = GetCurrentTimeSeconds() - startTime;
+
+	DebugRenderMessage( 10.0f, Rgba::YELLOW, Rgba::WHITE, "Respawn x%d (%u shapes): reload %.4fms, snapshot %.4fms per respawn"
+		, count, (uint) map->m_pristine.m_shapes.size(), reloadTime * 1000.0 / count, respawnTime * 1000.0 / count );
+
+	// Knock every live shape off its spawn, respawn, and compare with a fresh load
+	MapData fresh;
+	map->Load( filename.c_str() );
+	map->CaptureMapData( fresh );
+	for( Shape* shape : map->m_shapes )
+	{
+		shape->SetPosition( shape->GetPosition() + Vec2( 3.0f, -2.0f ) );
+		shape->m_rigidbody->SetAngularVelocity( shape->m_rigidbody->GetAngularVelocity() + 90.0f );
+	}
+	map->Respawn();
+	MapData respawned;
+	map->CaptureMapData( respawned );
+
+	// Shapes within a region can come back in a different order, so match them up per region
+	bool ok = fresh.m_shapes.size() == respawned.m_shapes.size() && fresh.m_regions.size() == respawned.m_regions.size();
+	uint numMismatched = 0;
+	for( uint regionIdx = 0; ok && regionIdx < (uint) fresh.m_regions.size(); ++regionIdx )
+	{
+		const MapRegion& freshRegion = fresh.m_regions[regionIdx];
+		const MapRegion& respawnedRegion = respawned.m_regions[regionIdx];
+		ok = freshRegion.m_coords.x == respawnedRegion.m_coords.x && freshRegion.m_coords.y == respawnedRegion.m_coords.y
+			&& freshRegion.m_numShapes == respawnedRegion.m_numShapes;
+
+		std::vector<bool> isMatched( freshRegion.m_numShapes, false );
+		for( uint runIdx = 0; ok && runIdx < respawnedRegion.m_numShapes; ++runIdx )
+		{
+			const ShapeDefinition& def = respawned.m_shapes[respawnedRegion.m_firstShape + runIdx];
+			uint matchIdx = 0;
+			while( matchIdx < freshRegion.m_numShapes
+				&& ( isMatched[matchIdx] || !IsShapeDefinitionBitIdentical( def, fresh.m_shapes[freshRegion.m_firstShape + matchIdx] ) ) )
+			{
+				++matchIdx;
+			}
+			if( matchIdx < freshRegion.m_numShapes )
+			{
+				isMatched[matchIdx] = true;
+			}
+			else
+			{
+				++numMismatched;
+			}
+		}
+	}
+	ok = ok && numMismatched == 0;
+
+	if( ok )
+	{
+		DebugRenderMessage( 10.0f, Rgba::GREEN, Rgba::WHITE, "Respawn: %u shapes identical to a fresh load", (uint) fresh.m_shapes.size() );
+	}
+	else
+	{
+		DebugRenderMessage( 10.0f, Rgba::RED, Rgba::WHITE, "Respawn: differs from a fresh load (%u of %u shapes, %u vs %u regions)"
+			, numMismatched, (uint) respawned.m_shapes.size(), (uint) respawned.m_regions.size(), (uint) fresh.m_regions.size() );
+	}
+	return ok;
+}
+
+//--------------------------------------------------------------------------
+/**
+* SaveRoundTripTest
+* Writes the current map plus a shape full of awkward floats, reads it back,
+* and checks every value comes back bit for bit.
+*/
+bool Game::SaveRoundTripTest( EventArgs& args )
+{
+	UNUSED( args );
+	Map* map = g_theGame->GetCurrentMap();
+	if( !map )
+	{
+		return false;
+	}
+
+	MapData written;
+	map->CaptureMapData( written );
+	written.m_endZone = Vec2( 0.1f, -1.0f / 3.0f );
+
+	ShapeDefinition awkward;
+	awkward.m_position			= Vec2( 1.0e-7f, -16777217.0f );
+	awkward.m_scale				= Vec2( 3.4028235e38f, 1.17549435e-38f );
+	awkward.m_rotation			= -0.0f;
+	awkward.m_radius			= 1.4e-45f;
+	awkward.m_extents			= Vec2( 0.3f, 2.0f / 3.0f );
+	awkward.m_localRight		= Vec2( 0.70710677f, 0.70710677f );
+	awkward.m_mass				= 123456.789f;
+	awkward.m_angularVelocity	= -12460.249f;
+	awkward.m_bodyType			= SHAPE_BODY_DYNAMIC;
+	awkward.m_alignment			= ALIGNMENT_ENEMY;
+	awkward.m_yRestricted		= true;
+	written.m_shapes.push_back( awkward );
+
+	ShapeDefinition spinner;
+	spinner.m_bodyType			= SHAPE_BODY_KINEMATIC;
+	spinner.m_angularVelocity	= 68.0f;
+	spinner.m_continuous		= true;
+	written.m_shapes.push_back( spinner );
+
+	TriggerDefinition awkwardTrigger;
+	awkwardTrigger.m_type		= TRIGGER_DAMAGE;
+	awkwardTrigger.m_center		= Vec2( -0.0f, 1.0f / 7.0f );
+	awkwardTrigger.m_radius		= 2.0e-38f;
+	awkwardTrigger.m_value		= 0.1f;
+	written.m_triggers.push_back( awkwardTrigger );
+	BuildMapRegions( written );
+
+	char const* testPath = "Data/Saved/roundtrip.tmp";
+	MapData read;
+	bool ok = WriteMapXml( testPath, written ) && ReadMapXml( testPath, read );
+	remove( testPath );
+
+	ok = ok && read.m_shapes.size() == written.m_shapes.size()
+		&& memcmp( &read.m_endZone, &written.m_endZone, sizeof( Vec2 ) ) == 0
+		&& read.m_triggers.size() == written.m_triggers.size();
+	for( uint triggerIdx = 0; ok && triggerIdx < (uint) written.m_triggers.size(); ++triggerIdx )
+	{
+		ok = IsTriggerDefinitionBitIdentical( written.m_triggers[triggerIdx], read.m_triggers[triggerIdx] );
+	}
+	uint shapeIdx = 0;
+	for( ; ok && shapeIdx < (uint) written.m_shapes.size(); ++shapeIdx )
+	{
+		ok = IsShapeDefinitionBitIdentical( written.m_shapes[shapeIdx], read.m_shapes[shapeIdx] );
+	}
+
+	if( ok )
+	{
+		DebugRenderMessage( 5.0f, Rgba::GREEN, Rgba::WHITE, "Save round trip: %u shapes identical", (uint) written.m_shapes.size() );
+	}
+	else
+	{
+		DebugRenderMessage( 5.0f, Rgba::RED, Rgba::WHITE, "Save round trip: mismatch at shape %u of %u", shapeIdx, (uint) written.m_shapes.size() );
+	}
+	return ok;
+}
+
+//--------------------------------------------------------------------------
+/**
+* PoolBenchmark
+* Spawns, updates and frees the current map's shapes with a heap new per
+* shape and then from a PillPool, and reports the time per pass of each.
+*/
+bool Game::PoolBenchmark( EventArgs& args )
+{
+	Map* map = g_theGame->GetCurrentMap();
+	if( !map || map->m_pristine.m_shapes.empty() )
+	{
+		return false;
+	}
+	int count = args.GetValue( "count", 20 );
+	int updates = args.GetValue( "updates", 10 );
+	const std::vector<ShapeDefinition>& definitions = map->m_pristine.m_shapes;
+
+	// Touches each shape the way the per-frame map loops do
+	float checksum = 0.0f;
+	double heapTimes[3] = { 0.0, 0.0, 0.0 };
+	std::vector<Shape*> heapShapes;
+	heapShapes.reserve( definitions.size() );
+	for( int runIdx = 0; runIdx < count; ++runIdx )
+	{
+		double startTime = GetCurrentTimeSeconds();
+		for( const ShapeDefinition& definition: definitions )
+		{
+			heapShapes.push_back( new Pill( definition ) );
+		}
+		heapTimes[0] += GetCurrentTimeSeconds() - startTime;
+
+		startTime = GetCurrentTimeSeconds();
+		for( int updateIdx = 0; updateIdx < updates; ++updateIdx )
+		{
+			for( Shape* s: heapShapes )
+			{
+				s->Update( 0.0f );
+				checksum += s->GetPosition().x;
+			}
+		}
+		heapTimes[1] += GetCurrentTimeSeconds() - startTime;
+
+		startTime = GetCurrentTimeSeconds();
+		for( Shape* s: heapShapes )
+		{
+			delete s;
+		}
+		heapShapes.clear();
+		heapTimes[2] += GetCurrentTimeSeconds() - startTime;
+	}
+
+	double poolTimes[3] = { 0.0, 0.0, 0.0 };
+	PillPool pool;
+	std::vector<Shape*> poolShapes;
+	poolShapes.reserve( definitions.size() );
+	for( int runIdx = 0; runIdx < count; ++runIdx )
+	{
+		double startTime = GetCurrentTimeSeconds();
+		for( const ShapeDefinition& definition: definitions )
+		{
+			poolShapes.push_back( pool.Create( definition ) );
+		}
+		poolTimes[0] += GetCurrentTimeSeconds() - startTime;
+
+		startTime = GetCurrentTimeSeconds();
+		for( int updateIdx = 0; updateIdx < updates; ++updateIdx )
+		{
+			for( Shape* s: poolShapes )
+			{
+				s->Update( 0.0f );
+				checksum += s->GetPosition().x;
+			}
+		}
+		poolTimes[1] += GetCurrentTimeSeconds() - startTime;
+
+		startTime = GetCurrentTimeSeconds();
+		pool.DestroyAll();
+		poolShapes.clear();
+		poolTimes[2] += GetCurrentTimeSeconds() - startTime;
+	}
+
+	double toMs = 1000.0 / count;
+	DebugRenderMessage( 10.0f, Rgba::YELLOW, Rgba::WHITE, "Pool bench x%d (%u shapes, %d updates, checksum %g)"
+		, count, (uint) definitions.size(), updates, checksum );
+	DebugRenderMessage( 10.0f, Rgba::YELLOW, Rgba::WHITE, "  heap: load %.4fms, update %.4fms, unload %.4fms"
+		, heapTimes[0] * toMs, heapTimes[1] * toMs, heapTimes[2] * toMs );
+	DebugRenderMessage( 10.0f, Rgba::YELLOW, Rgba::WHITE, "  pool: load %.4fms, update %.4fms, unload %.4fms"
+		, poolTimes[0] * toMs, poolTimes[1] * toMs, poolTimes[2] * toMs );
+	return true;
+}
+
+//--------------------------------------------------------------------------
+/**
+* ReloadSoakTest
+* Reloads the current map over and over; the live timer count and the timer
+* and pill storage must be the same after the last load as after the first.
+*/
+bool Game::ReloadSoakTest( EventArgs& args )
+{
+	Map* map = g_theGame->GetCurrentMap();
+	if( !map || map->m_filename.empty() )
+	{
+		return false;
+	}
+	int count = args.GetValue( "count", 1000 );
+	std::string filename = map->m_filename;
+	TimerService* timers = g_theApp->m_gameTimers;
+
+	map->Load( filename.c_str() );
+	uint firstTimers = timers->GetNumTimers();
+	uint firstTimerCapacity = timers->GetCapacity();
+	uint firstPillCapacity = map->m_pillPool.GetCapacity();
+
+	double startTime = GetCurrentTimeSeconds();
+	for( int runIdx = 1; runIdx < count; ++runIdx )
+	{
+		map->Load( filename.c_str() );
+	}
+	double soakTime = GetCurrentTimeSeconds() - startTime;
+
+	bool flat = timers->GetNumTimers() == firstTimers
+		&& timers->GetCapacity() == firstTimerCapacity
+		&& map->m_pillPool.GetCapacity() == firstPillCapacity;
+	DebugRenderMessage( 10.0f, flat ? Rgba::GREEN : Rgba::RED, Rgba::WHITE, "Soak x%d (%.4fms per load): timers %u -> %u (capacity %u -> %u), pill capacity %u -> %u"
+		, count, soakTime * 1000.0 / count, firstTimers, timers->GetNumTimers(), firstTimerCapacity, timers->GetCapacity()
+		, firstPillCapacity, map->m_pillPool.GetCapacity() );
+	return flat;
+}
+
+//--------------------------------------------------------------------------
+// Helper
+static void MakeShapeGrid( std::vector<ShapeDefinition>& out, int count )
+{
+	int rowLength = (int) sqrtf( (float) count ) + 1;
+	ShapeDefinition definition;
+	definition.m_scale = Vec2::ONE;
+	definition.m_extents = Vec2( 0.5f, 0.25f );
+	definition.m_radius = 0.25f;
+	out.reserve( out.size() + count );
+	for( int shapeIdx = 0; shapeIdx < count; ++shapeIdx )
+	{
+		definition.m_position = Vec2( (float) ( shapeIdx % rowLength ) * 2.0f, (float) ( shapeIdx / rowLength ) * 2.0f );
+		out.push_back( definition );
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* ShapeFrameBenchmark
+* Adds a grid of shapes to the current map and times the per-shape update and
+* render work done per object against the packed table passes. Vertex building
+* is timed without drawing; the object path issued one draw per shape. Both
+* paths blend from the same previous shapes and must build identical vertices.
+*/
+bool Game::ShapeFrameBenchmark( EventArgs& args )
+{
+	Map* map = g_theGame->GetCurrentMap();
+	if( !map )
+	{
+		return false;
+	}
+	int count = args.GetValue( "count", 50000 );
+	int frames = args.GetValue( "frames", 10 );
+
+	std::vector<ShapeDefinition> definitions;
+	MakeShapeGrid( definitions, count );
+	std::vector<Shape*> spawned;
+	map->AddShapes( definitions.data(), (uint) definitions.size(), spawned );
+	std::vector<ShapeHandle> added;
+	for( Shape* s: spawned )
+	{
+		added.push_back( s->m_handle );
+	}
+
+	// Both paths blend from the same previous shapes, the way RenderShapes does
+	float blend = g_theApp->m_physicsSteps->GetInterpolation();
+	map->GatherShapeState();
+	std::vector<Pillbox2> previous = map->m_shapeTables.m_prevWorldShapes;
+	auto addObjectVerts = [&]( std::vector<Vertex_PCU>& out, Shape* s, uint denseIdx )
+	{
+		Rgba boarderColor = map->HasShapeFlag( s->m_handle, SHAPE_FLAG_SELECTED ) ? Rgba::WHITE : s->DeterminColor( map->HasShapeFlag( s->m_handle, SHAPE_FLAG_TOUCHING ) );
+		AddVertsForPill2D( out, previous[denseIdx], static_cast<PillboxCollider2D*>( s->m_collider )->GetWorldShape(), blend, s->GetFillColor(), boarderColor );
+	};
+
+	// Per object: virtual update, then a vertex array built from the collider for each shape
+	std::vector<Vertex_PCU> verts;
+	size_t objectVerts = 0;
+	double startTime = GetCurrentTimeSeconds();
+	for( int frameIdx = 0; frameIdx < frames; ++frameIdx )
+	{
+		for( Shape* s: map->m_shapes )
+		{
+			s->Update( 0.0f );
+		}
+		uint denseIdx = 0;
+		for( Shape* s: map->m_shapes )
+		{
+			verts.clear();
+			addObjectVerts( verts, s, denseIdx++ );
+			objectVerts += verts.size();
+		}
+	}
+	double objectTime = GetCurrentTimeSeconds() - startTime;
+
+	// Packed: one gather pass, then one sweep over the tables into a single array
+	size_t tableVerts = 0;
+	startTime = GetCurrentTimeSeconds();
+	for( int frameIdx = 0; frameIdx < frames; ++frameIdx )
+	{
+		map->GatherShapeState();
+		map->m_shapeVerts.clear();
+		const ShapeTables& tables = map->m_shapeTables;
+		for( uint rowIdx = 0; rowIdx < tables.GetCount(); ++rowIdx )
+		{
+			const Rgba& boarderColor = tables.HasFlag( rowIdx, SHAPE_FLAG_SELECTED ) ? Rgba::WHITE : tables.m_borderColors[rowIdx];
+			AddVertsForPill2D( map->m_shapeVerts, tables.m_prevWorldShapes[rowIdx], tables.m_worldShapes[rowIdx], blend, tables.m_fillColors[rowIdx], boarderColor );
+		}
+		tableVerts += map->m_shapeVerts.size();
+	}
+	double tableTime = GetCurrentTimeSeconds() - startTime;
+
+	// Untimed: the whole frame from each path, vertex for vertex
+	verts.clear();
+	uint denseIdx = 0;
+	for( Shape* s: map->m_shapes )
+	{
+		addObjectVerts( verts, s, denseIdx++ );
+	}
+	bool isIdentical = verts.size() == map->m_shapeVerts.size()
+		&& ( verts.empty() || memcmp( verts.data(), map->m_shapeVerts.data(), verts.size() * sizeof( Vertex_PCU ) ) == 0 );
+
+	uint numShapes = map->GetNumShapes();
+	for( ShapeHandle handle: added )
+	{
+		map->RemoveShape( map->GetShape( handle ) );
+	}
+
+	DebugRenderMessage( 10.0f, isIdentical && objectVerts == tableVerts ? Rgba::YELLOW : Rgba::RED, Rgba::WHITE
+		, "Shape frame x%d (%u shapes): per object %.4fms (%u draws), tables %.4fms (1 draw), vertices %s"
+		, frames, numShapes, objectTime * 1000.0 / frames, numShapes, tableTime * 1000.0 / frames, isIdentical ? "identical" : "DIFFER" );
+	return isIdentical;
+}
+
+//--------------------------------------------------------------------------
+/**
+* QueryBenchmark
+* Adds a grid of shapes to the current map and times editor picking through the
+* spatial index against a scan of every shape, checking both pick the same distance.
+*/
+bool Game::QueryBenchmark( EventArgs& args )
+{
+	Map* map = g_theGame->GetCurrentMap();
+	if( !map )
+	{
+		return false;
+	}
+	int count = args.GetValue( "count", 100000 );
+	int queries = args.GetValue( "queries", 1000 );
+
+	int rowLength = (int) sqrtf( (float) count ) + 1;
+	std::vector<ShapeDefinition> definitions;
+	MakeShapeGrid( definitions, count );
+	std::vector<Shape*> spawned;
+	map->AddShapes( definitions.data(), (uint) definitions.size(), spawned );
+	std::vector<ShapeHandle> added;
+	for( Shape* s: spawned )
+	{
+		added.push_back( s->m_handle );
+	}
+
+	std::vector<Vec2> points;
+	points.reserve( queries );
+	// Low-discrepancy spread over the grid and a margin around it, the same every run
+	float extent = (float) rowLength * 2.0f + 8.0f;
+	for( int queryIdx = 0; queryIdx < queries; ++queryIdx )
+	{
+		float u = fmodf( (float) queryIdx * 0.618034f, 1.0f );
+		float v = fmodf( (float) queryIdx * 0.754878f, 1.0f );
+		points.push_back( Vec2( u * extent - 4.0f, v * extent - 4.0f ) );
+	}
+
+	std::vector<float> scanDistances;
+	scanDistances.reserve( queries );
+	double startTime = GetCurrentTimeSeconds();
+	for( const Vec2& point: points )
+	{
+		float closestDistance = 999999999999.0f;
+		for( Shape* testShape : map->m_shapes )
+		{
+			closestDistance = std::min( closestDistance, ( point - testShape->GetPosition() ).GetLengthSquared() );
+		}
+		scanDistances.push_back( closestDistance );
+	}
+	double scanTime = GetCurrentTimeSeconds() - startTime;
+
+	uint mismatches = 0;
+	std::vector<Shape*> around;
+	startTime = GetCurrentTimeSeconds();
+	for( uint queryIdx = 0; queryIdx < (uint) points.size(); ++queryIdx )
+	{
+		Shape* nearest = map->QueryNearest( points[queryIdx] );
+		around.clear();
+		map->QueryRadius( points[queryIdx], 1.0f, around );
+		if( !nearest || ( points[queryIdx] - nearest->GetPosition() ).GetLengthSquared() != scanDistances[queryIdx] )
+		{
+			++mismatches;
+		}
+	}
+	double indexTime = GetCurrentTimeSeconds() - startTime;
+
+	uint numShapes = map->GetNumShapes();
+	for( ShapeHandle handle: added )
+	{
+		map->RemoveShape( map->GetShape( handle ) );
+	}
+
+	DebugRenderMessage( 10.0f, mismatches == 0 ? Rgba::YELLOW : Rgba::RED, Rgba::WHITE
+		, "Query x%d (%u shapes): scan %.4fms, index %.4fms per pick, %u mismatches"
+		, queries, numShapes, scanTime * 1000.0 / queries, indexTime * 1000.0 / queries, mismatches );
+	return mismatches == 0;
+}
+
+//--------------------------------------------------------------------------
+/**
+* SpawnBenchmark
+* Times adding a grid of shapes to the current map one at a time against one AddShapes batch.
+*/
+bool Game::SpawnBenchmark( EventArgs& args )
+{
+	Map* map = g_theGame->GetCurrentMap();
+	if( !map )
+	{
+		return false;
+	}
+	int count = args.GetValue( "count", 10000 );
+	std::vector<ShapeDefinition> definitions;
+	MakeShapeGrid( definitions, count );
+
+	// Both runs start from a grown pool so neither pays for the blocks
+	map->m_pillPool.Reserve( count );
+	std::vector<Shape*> spawned;
+	double startTime = GetCurrentTimeSeconds();
+	for( const ShapeDefinition& definition: definitions )
+	{
+		spawned.push_back( map->SpawnShape( definition ) );
+	}
+	double singleTime = GetCurrentTimeSeconds() - startTime;
+	for( Shape* s: spawned )
+	{
+		map->RemoveShape( s );
+	}
+
+	spawned.clear();
+	startTime = GetCurrentTimeSeconds();
+	map->AddShapes( definitions.data(), (uint) definitions.size(), spawned );
+	double batchTime = GetCurrentTimeSeconds() - startTime;
+	for( Shape* s: spawned )
+	{
+		map->RemoveShape( s );
+	}
+
+	DebugRenderMessage( 10.0f, Rgba::YELLOW, Rgba::WHITE, "Spawn %d shapes: one at a time %.4fms, batch %.4fms"
+		, count, singleTime * 1000.0, batchTime * 1000.0 );
+	return true;
+}
+
+//--------------------------------------------------------------------------
+/**
+* UpdateLoadTest
+*/
+void Game::UpdateLoadTest()
+{
+	for( MapLoadJob*& job : m_loadTestJobs )
+	{
+		if( job->IsFinished() )
+		{
+			job->Join();
+			DebugRenderMessage( 5.0f, job->Succeeded() ? Rgba::GREEN : Rgba::RED, Rgba::WHITE, "Loaded %s: %u shapes (frame %d)"
+				, job->GetFilename().c_str(), (uint) job->GetData().m_shapes.size(), g_theApp->GetFrameCount() );
+			SAFE_DELETE( job );
+		}
+	}
+	m_loadTestJobs.erase( std::remove( m_loadTestJobs.begin(), m_loadTestJobs.end(), nullptr ), m_loadTestJobs.end() );
+}
+
+//--------------------------------------------------------------------------
+/**
+* TriggerBenchmark
+* Times a frame of trigger lookups for a fixed set of moving bodies against fields
+* of 100 up to 100000 triggers at the same density, checking each frame against
+* a scan of every trigger. The field's cost should stay flat as the count grows.
+*/
+bool Game::TriggerBenchmark( EventArgs& args )
+{
+	int bodies = args.GetValue( "bodies", 1000 );
+	int frames = args.GetValue( "frames", 10 );
+
+	uint mismatches = 0;
+	std::vector<uint> inside;
+	for( int count = 100; count <= 100000; count *= 10 )
+	{
+		// Low-discrepancy spread, one trigger per 36 square units, every 1000th one huge
+		float extent = sqrtf( (float) count ) * 6.0f;
+		std::vector<TriggerDefinition> triggers( count );
+		for( int triggerIdx = 0; triggerIdx < count; ++triggerIdx )
+		{
+			TriggerDefinition& trigger = triggers[triggerIdx];
+			trigger.m_type = (eTriggerType) ( triggerIdx % NUM_TRIGGER_TYPES );
+			trigger.m_center = Vec2( fmodf( (float) triggerIdx * 0.618034f, 1.0f ) * extent, fmodf( (float) triggerIdx * 0.754878f, 1.0f ) * extent );
+			trigger.m_radius = triggerIdx % 1000 == 999 ? 40.0f : 1.0f + fmodf( (float) triggerIdx * 0.414214f, 1.0f ) * 2.0f;
+		}
+		TriggerField field;
+		field.Build( triggers.data(), (uint) triggers.size() );
+
+		std::vector<Vec2> positions( bodies );
+		for( int bodyIdx = 0; bodyIdx < bodies; ++bodyIdx )
+		{
+			positions[bodyIdx] = Vec2( fmodf( (float) bodyIdx * 0.569840f, 1.0f ) * extent, fmodf( (float) bodyIdx * 0.324718f, 1.0f ) * extent );
+		}
+
+		size_t fieldContacts = 0;
+		double startTime = GetCurrentTimeSeconds();
+		for( int frameIdx = 0; frameIdx < frames; ++frameIdx )
+		{
+			for( Vec2& position: positions )
+			{
+				position += Vec2( 0.25f, 0.125f );
+				inside.clear();
+				field.GatherAt( position, inside );
+				fieldContacts += inside.size();
+			}
+		}
+		double fieldTime = GetCurrentTimeSeconds() - startTime;
+
+		// One frame of the scan is plenty at the larger counts
+		size_t scanContacts = 0;
+		startTime = GetCurrentTimeSeconds();
+		for( const Vec2& position: positions )
+		{
+			for( const TriggerDefinition& trigger: triggers )
+			{
+				if( ( position - trigger.m_center ).GetLengthSquared() < trigger.m_radius * trigger.m_radius )
+				{
+					++scanContacts;
+				}
+			}
+		}
+		double scanTime = GetCurrentTimeSeconds() - startTime;
+
+		size_t lastFieldContacts = 0;
+		for( const Vec2& position: positions )
+		{
+			inside.clear();
+			field.GatherAt( position, inside );
+			lastFieldContacts += inside.size();
+		}
+		if( scanContacts != lastFieldContacts )
+		{
+			++mismatches;
+		}
+
+		DebugRenderMessage( 10.0f, scanContacts == lastFieldContacts ? Rgba::YELLOW : Rgba::RED, Rgba::WHITE
+			, "Triggers %d, %d bodies: field %.4fms, scan %.4fms per frame (%u contacts/frame)"
+			, count, bodies, fieldTime * 1000.0 / frames, scanTime * 1000.0, (uint) ( fieldContacts / frames ) );
+	}
+	return mismatches == 0;
+}
+
+//--------------------------------------------------------------------------
+/**
+* BroadphaseBenchmark
+* Tiles map3's layout scale times into the current map, then times the contact
+* pass and checks its contacts against testing every pair of shapes.
+*/
+bool Game::BroadphaseBenchmark( EventArgs& args )
+{
+	Map* map = g_theGame->GetCurrentMap();
+	if( !map )
+	{
+		return false;
+	}
+	int scale = args.GetValue( "scale", 100 );
+	int frames = args.GetValue( "frames", 10 );
+
+	MapData layout;
+	if( !ReadMapFile( "Data/Saved/map3.map", layout ) || layout.m_shapes.empty() )
+	{
+		DebugRenderMessage( 10.0f, Rgba::RED, Rgba::WHITE, "broadphasebench: couldn't read Data/Saved/map3.map" );
+		return false;
+	}
+	Vec2 mins = layout.m_shapes[0].m_position;
+	Vec2 maxs = mins;
+	for( const ShapeDefinition& definition: layout.m_shapes )
+	{
+		mins = Vec2( std::min( mins.x, definition.m_position.x ), std::min( mins.y, definition.m_position.y ) );
+		maxs = Vec2( std::max( maxs.x, definition.m_position.x ), std::max( maxs.y, definition.m_position.y ) );
+	}
+
+	// Copies sit side by side with a gap, well away from the current level
+	Vec2 stride = maxs - mins + Vec2( 8.0f, 8.0f );
+	int rowLength = (int) ceilf( sqrtf( (float) scale ) );
+	std::vector<ShapeDefinition> definitions;
+	definitions.reserve( layout.m_shapes.size() * scale );
+	for( int copyIdx = 0; copyIdx < scale; ++copyIdx )
+	{
+		Vec2 offset = Vec2( 1000.0f + stride.x * (float) ( copyIdx % rowLength ), 1000.0f + stride.y * (float) ( copyIdx / rowLength ) );
+		for( ShapeDefinition definition: layout.m_shapes )
+		{
+			definition.m_position += offset - mins;
+			definition.m_alignment = ALIGNMENT_NEUTRAL;
+			definitions.push_back( definition );
+		}
+	}
+	std::vector<Shape*> spawned;
+	map->AddShapes( definitions.data(), (uint) definitions.size(), spawned );
+	map->GatherShapeState();
+
+	// The first pass sorts everything in; later ones only repair the order
+	double startTime = GetCurrentTimeSeconds();
+	map->FindContacts();
+	double firstTime = GetCurrentTimeSeconds() - startTime;
+	startTime = GetCurrentTimeSeconds();
+	for( int frameIdx = 0; frameIdx < frames; ++frameIdx )
+	{
+		map->FindContacts();
+	}
+	double sweepTime = GetCurrentTimeSeconds() - startTime;
+
+	const ShapeTables& tables = map->m_shapeTables;
+	uint numShapes = tables.GetCount();
+	uint numPairs = 0;
+	uint bruteContacts = 0;
+	startTime = GetCurrentTimeSeconds();
+	for( uint rowA = 0; rowA < numShapes; ++rowA )
+	{
+		for( uint rowB = rowA + 1; rowB < numShapes; ++rowB )
+		{
+			if( !tables.HasFlag( rowA, SHAPE_FLAG_DYNAMIC ) && !tables.HasFlag( rowB, SHAPE_FLAG_DYNAMIC ) )
+			{
+				continue;
+			}
+			++numPairs;
+			if( GetPillboxSeparation( tables.m_worldShapes[rowA], tables.m_worldShapes[rowB] ) <= 0.0f )
+			{
+				++bruteContacts;
+			}
+		}
+	}
+	double bruteTime = GetCurrentTimeSeconds() - startTime;
+
+	uint numCandidates = (uint) map->m_broadphase.GetCandidates().size();
+	uint numContacts = (uint) map->m_contacts.size();
+	for( Shape* s: spawned )
+	{
+		map->RemoveShape( s );
+	}
+	map->FindContacts();
+
+	bool matches = numContacts == bruteContacts;
+	DebugRenderMessage( 10.0f, matches ? Rgba::YELLOW : Rgba::RED, Rgba::WHITE
+		, "Broadphase, map3 x%d (%u shapes): %u candidates of %u pairs, %u contacts (all pairs found %u)"
+		, scale, numShapes, numCandidates, numPairs, numContacts, bruteContacts );
+	DebugRenderMessage( 10.0f, matches ? Rgba::YELLOW : Rgba::RED, Rgba::WHITE
+		, "Broadphase: first pass %.4fms, then %.4fms per frame; all pairs %.4fms"
+		, firstTime * 1000.0, sweepTime * 1000.0 / frames, bruteTime * 1000.0 );
+	return matches;
+}
+
+//--------------------------------------------------------------------------
+/**
+* NarrowphaseTest
+* Pairs up the current map's shapes at offsets around touching distance and checks
+* the batched kernel against its scalar path and against DoesPillboxOverlapPillbox,
+* then times all three.
+*/
+bool Game::NarrowphaseTest( EventArgs& args )
+{
+	Map* map = g_theGame->GetCurrentMap();
+	if( !map || map->GetNumShapes() < 2 )
+	{
+		DebugRenderMessage( 10.0f, Rgba::RED, Rgba::WHITE, "narrowphasetest: needs a map with shapes" );
+		return false;
+	}
+	int count = args.GetValue( "count", 100000 );
+	int frames = args.GetValue( "frames", 10 );
+	float tolerance = args.GetValue( "tolerance", 0.0001f );
+
+	// Low-discrepancy picks of two shapes, the second moved to a spot around the first
+	const std::vector<Pillbox2>& shapes = map->m_shapeTables.m_worldShapes;
+	uint numShapes = (uint) shapes.size();
+	std::vector<Pillbox2> pillsA;
+	std::vector<Pillbox2> pillsB;
+	PillboxPairBatch batch;
+	batch.Reserve( count );
+	for( int pairIdx = 0; pairIdx < count; ++pairIdx )
+	{
+		const Pillbox2& a = shapes[(uint) ( fmodf( (float) pairIdx * 0.618034f, 1.0f ) * numShapes ) % numShapes];
+		Pillbox2 b = shapes[(uint) ( fmodf( (float) pairIdx * 0.754878f, 1.0f ) * numShapes ) % numShapes];
+		float reach = ( GetPillboxBoundRadius( a ) + GetPillboxBoundRadius( b ) ) * 1.2f;
+		Vec2 offset = Vec2( fmodf( (float) pairIdx * 0.569840f, 1.0f ) * 2.0f - 1.0f, fmodf( (float) pairIdx * 0.324718f, 1.0f ) * 2.0f - 1.0f ) * reach;
+		b.m_obb.m_center = a.m_obb.m_center + offset;
+		pillsA.push_back( a );
+		pillsB.push_back( b );
+		batch.Add( a, b );
+	}
+
+	std::vector<float> separations[2];
+	double times[3];
+	for( int runIdx = 0; runIdx < 2; ++runIdx )
+	{
+		separations[runIdx].resize( count );
+		double startTime = GetCurrentTimeSeconds();
+		for( int frameIdx = 0; frameIdx < frames; ++frameIdx )
+		{
+			batch.ComputeSeparations( separations[runIdx].data(), runIdx == 0 );
+		}
+		times[runIdx] = GetCurrentTimeSeconds() - startTime;
+	}
+	std::vector<bool> overlaps( count );
+	double startTime = GetCurrentTimeSeconds();
+	for( int frameIdx = 0; frameIdx < frames; ++frameIdx )
+	{
+		for( int pairIdx = 0; pairIdx < count; ++pairIdx )
+		{
+			overlaps[pairIdx] = DoesPillboxOverlapPillbox( pillsA[pairIdx], pillsB[pairIdx] );
+		}
+	}
+	times[2] = GetCurrentTimeSeconds() - startTime;
+
+	// Pairs within tolerance of touching may land either side
+	float maxDifference = 0.0f;
+	uint numMismatched = 0;
+	uint numDisagreements = 0;
+	uint numOverlapping = 0;
+	for( int pairIdx = 0; pairIdx < count; ++pairIdx )
+	{
+		float separation = separations[0][pairIdx];
+		float difference = fabsf( separation - separations[1][pairIdx] );
+		maxDifference = std::max( maxDifference, difference );
+		if( difference > tolerance * std::max( 1.0f, fabsf( separation ) )
+			|| fabsf( separation - GetPillboxSeparation( pillsA[pairIdx], pillsB[pairIdx] ) ) > tolerance * std::max( 1.0f, fabsf( separation ) ) )
+		{
+			++numMismatched;
+		}
+		if( fabsf( separation ) > tolerance && ( separation <= 0.0f ) != overlaps[pairIdx] )
+		{
+			++numDisagreements;
+		}
+		numOverlapping += separation <= 0.0f ? 1 : 0;
+	}
+
+	bool passed = numMismatched == 0 && numDisagreements == 0;
+#if defined( PILLBOX_BATCH_SSE )
+	const char* kernelName = "SSE";
+#else
+	const char* kernelName = "scalar only";
+#endif
+	DebugRenderMessage( 10.0f, passed ? Rgba::YELLOW : Rgba::RED, Rgba::WHITE
+		, "Narrowphase (%s), %d pairs, %u overlapping: max batch difference %g, %u outside tolerance, %u disagree with DoesPillboxOverlapPillbox"
+		, kernelName, count, numOverlapping, maxDifference, numMismatched, numDisagreements );
+	DebugRenderMessage( 10.0f, passed ? Rgba::YELLOW : Rgba::RED, Rgba::WHITE
+		, "Narrowphase per frame: batch %.4fms, batch scalar %.4fms, one pair at a time %.4fms"
+		, times[0] * 1000.0 / frames, times[1] * 1000.0 / frames, times[2] * 1000.0 / frames );
+	return passed;
+}
+
+//--------------------------------------------------------------------------
+/**
+* SleepBenchmark
+* Adds a grid of resting dynamic shapes to the current map and times physics
+* steps with them all awake, then again once they've been put to sleep. The
+* map's own sleep work per step is timed too, and the active row list is
+* checked against a scan of every row.
+*/
+bool Game::SleepBenchmark( EventArgs& args )
+{
+	Map* map = g_theGame->GetCurrentMap();
+	if( !map )
+	{
+		return false;
+	}
+	int count = args.GetValue( "count", 5000 );
+	int steps = args.GetValue( "steps", 60 );
+
+	std::vector<ShapeDefinition> definitions;
+	MakeShapeGrid( definitions, count );
+	for( ShapeDefinition& definition: definitions )
+	{
+		definition.m_bodyType = SHAPE_BODY_DYNAMIC;
+		definition.m_position += Vec2( 1000.0f, 1000.0f );
+	}
+	std::vector<Shape*> spawned;
+	map->AddShapes( definitions.data(), (uint) definitions.size(), spawned );
+
+	float stepSeconds = g_theApp->m_physicsSteps->GetStepSeconds();
+	double times[2];
+	double sleepTimes[2];
+	uint numAsleep[2];
+	uint numActive[2];
+	bool isListValid = true;
+	for( int runIdx = 0; runIdx < 2; ++runIdx )
+	{
+		// Enough rest in one go to put everything still to sleep on the second run
+		map->GatherShapeState();
+		map->FindContacts();
+		map->UpdateSleeping( runIdx == 0 ? 0.0f : 999.0f );
+		numAsleep[runIdx] = map->m_numAsleep;
+
+		double startTime = GetCurrentTimeSeconds();
+		for( int stepIdx = 0; stepIdx < steps; ++stepIdx )
+		{
+			g_thePhysicsSystem->Update( stepSeconds );
+		}
+		times[runIdx] = GetCurrentTimeSeconds() - startTime;
+
+		startTime = GetCurrentTimeSeconds();
+		for( int stepIdx = 0; stepIdx < steps; ++stepIdx )
+		{
+			map->WakeSleepersInReach( stepSeconds );
+			map->UpdateSleeping( 0.0f );
+		}
+		sleepTimes[runIdx] = GetCurrentTimeSeconds() - startTime;
+
+		const ShapeTables& tables = map->m_shapeTables;
+		numActive[runIdx] = (uint) tables.m_activeRows.size();
+		uint numExpectedActive = 0;
+		uint numFlaggedAsleep = 0;
+		for( uint rowIdx = 0; rowIdx < tables.GetCount(); ++rowIdx )
+		{
+			bool isAsleep = tables.HasFlag( rowIdx, SHAPE_FLAG_ASLEEP );
+			bool isActive = map->m_shapes[rowIdx]->m_definition.m_bodyType != SHAPE_BODY_STATIC && !isAsleep;
+			numExpectedActive += isActive ? 1 : 0;
+			numFlaggedAsleep += isAsleep ? 1 : 0;
+			isListValid = isListValid && tables.IsActive( rowIdx ) == isActive
+				&& ( !isActive || tables.m_activeRows[tables.m_activeSlots[rowIdx]] == rowIdx );
+		}
+		isListValid = isListValid && numExpectedActive == numActive[runIdx] && numFlaggedAsleep == map->m_numAsleep;
+	}
+
+	uint numShapes = map->GetNumShapes();
+	for( Shape* s: spawned )
+	{
+		map->RemoveShape( s );
+	}
+
+	DebugRenderMessage( 10.0f, Rgba::YELLOW, Rgba::WHITE
+		, "Physics step (%u shapes): %u asleep %.4fms, %u asleep %.4fms"
+		, numShapes, numAsleep[0], times[0] * 1000.0 / steps, numAsleep[1], times[1] * 1000.0 / steps );
+	DebugRenderMessage( 10.0f, isListValid ? Rgba::YELLOW : Rgba::RED, Rgba::WHITE
+		, "Sleep update: %u active %.4fms, %u active %.4fms, active list %s"
+		, numActive[0], sleepTimes[0] * 1000.0 / steps, numActive[1], sleepTimes[1] * 1000.0 / steps, isListValid ? "matches" : "WRONG" );
+	return isListValid;
+}
+
+//--------------------------------------------------------------------------
+// A live level's body, held static while a test steps the physics system
+struct ParkedBody
+{
+	Rigidbody2D* m_rigidbody;
+	ePhysicsSimulationType m_simType;
+	Vec2 m_velocity;
+	float m_angularVelocity;
+};
+
+//--------------------------------------------------------------------------
+/**
+* DeterminismTest
+* Plays map1 to map3 twice each from a fresh map in deterministic mode, with no
+* input, and compares the rigidbody hashes after every physics step. The physics
+* system steps every body it has, so the loaded levels are parked as static for
+* the test and left as they were.
+* determinismtest steps=600
+*/
+bool Game::DeterminismTest( EventArgs& args )
+{
+	int steps = args.GetValue( "steps", 600 );
+	float stepSeconds = g_theApp->m_physicsSteps->GetStepSeconds();
+
+	std::vector<ParkedBody> parked;
+	for( Map* liveMap: g_theGame->m_maps )
+	{
+		for( Shape* shape: liveMap->m_shapes )
+		{
+			Rigidbody2D* rigidbody = shape->m_rigidbody;
+			parked.push_back( { rigidbody, rigidbody->GetSimulationType(), rigidbody->GetVelocity(), rigidbody->GetAngularVelocity() } );
+			rigidbody->SetSimulationType( PHYSICS_SIM_STATIC );
+		}
+	}
+
+	auto runLevel = [&]( const MapData& layout, std::vector<uint64_t>& outHashes )
+	{
+		// Well away from whatever level is running
+		std::vector<ShapeDefinition> definitions = layout.m_shapes;
+		for( ShapeDefinition& definition: definitions )
+		{
+			definition.m_position += Vec2( 1000.0f, 1000.0f );
+		}
+		Map* map = new Map( g_theRenderer );
+		map->SetDeterministic( true );
+		std::vector<Shape*> spawned;
+		map->AddShapes( definitions.data(), (uint) definitions.size(), spawned );
+		map->GatherShapeState();
+
+		outHashes.clear();
+		outHashes.push_back( map->GetPhysicsStateHash() );
+		for( int stepIdx = 0; stepIdx < steps; ++stepIdx )
+		{
+			map->BeginPhysicsStep();
+			g_thePhysicsSystem->Update( stepSeconds );
+			map->EndPhysicsStep( stepSeconds );
+			map->UpdateSleeping( stepSeconds );
+			map->m_contactEvents.clear();
+			outHashes.push_back( map->GetLastStepHash() );
+		}
+		delete map;
+	};
+
+	bool passed = true;
+	std::vector<uint64_t> hashes[2];
+	for( uint levelIdx = 1; levelIdx <= 3; ++levelIdx )
+	{
+		std::string path = Stringf( "Data/Saved/map%u.map", levelIdx );
+		MapData layout;
+		if( !ReadMapFile( path.c_str(), layout ) )
+		{
+			DebugRenderMessage( 10.0f, Rgba::RED, Rgba::WHITE, "determinismtest: couldn't read %s", path.c_str() );
+			passed = false;
+			continue;
+		}
+		runLevel( layout, hashes[0] );
+		runLevel( layout, hashes[1] );
+
+		int firstMismatch = -1;
+		for( uint stepIdx = 0; stepIdx < (uint) hashes[0].size() && firstMismatch < 0; ++stepIdx )
+		{
+			firstMismatch = hashes[0][stepIdx] != hashes[1][stepIdx] ? (int) stepIdx : -1;
+		}
+		if( firstMismatch >= 0 )
+		{
+			DebugRenderMessage( 10.0f, Rgba::RED, Rgba::WHITE, "determinismtest: %s diverged at step %d (%016llx vs %016llx)"
+				, path.c_str(), firstMismatch, (unsigned long long) hashes[0][firstMismatch], (unsigned long long) hashes[1][firstMismatch] );
+			passed = false;
+		}
+		else
+		{
+			DebugRenderMessage( 10.0f, Rgba::GREEN, Rgba::WHITE, "determinismtest: %s matched over %d steps (%016llx)"
+				, path.c_str(), steps, (unsigned long long) hashes[0].back() );
+		}
+	}
+
+	for( const ParkedBody& body: parked )
+	{
+		body.m_rigidbody->SetSimulationType( body.m_simType );
+		body.m_rigidbody->SetVelocity( body.m_velocity );
+		body.m_rigidbody->SetAngularVelocity( body.m_angularVelocity );
+	}
+	return passed;
+}
@@ -10,15 +10,53 @@
 #include "Engine/Renderer/Debug/DebugRenderSystem.hpp"
 #include "Engine/Physics/Rigidbody2D.hpp"
 #include "Engine/Physics/Collider2D.hpp"
-#include "Engine/Core/XMLUtils.hpp"
+#include "Engine/Physics/PillboxCollider2D.hpp"
+#include "Game/MapSaveJob.hpp"
 #include "Engine/Core/Time/Clock.hpp"
 #include "Game/App.hpp"
 #include "Game/Shapes/Shape.hpp"
 #include "Game/Shapes/Pill.hpp"
+#include "Game/Shapes/PillboxMath.hpp"
+#include "Game/Shapes/PillboxSweep.hpp"
+#include "Engine/Math/MathUtils.hpp"
 #include "Game/GameCommon.hpp"
 #include "Game/FollowCamera2D.hpp"
 #include "Game/GameController.hpp"
-#include "Engine/Core/Time/StopWatch.hpp"
+#include "Game/MapFormat.hpp"
+#include "Game/TimerService.hpp"
+#include "Game/FixedStepScheduler.hpp"
+#include <algorithm>
+#include <limits.h>
+#include <math.h>
+
+//--------------------------------------------------------------------------
+constexpr uint SHAPES_SPAWNED_PER_FRAME = 256;
+
+// Regions closer than this to the camera focus are loaded; they unload once
+// past the distance plus the margin, so hovering at an edge doesn't thrash.
+constexpr float REGION_LOAD_DISTANCE	= 32.0f;
+constexpr float REGION_UNLOAD_MARGIN	= 8.0f;
+
+// Continuous collision. Neighbours are looked for this far past a body's swept
+// bounds; anything moving further than that in one step should be ccd itself.
+constexpr float CONTINUOUS_QUERY_MARGIN	= 4.0f;
+constexpr float CONTINUOUS_SLOP			= 0.01f;
+constexpr int CONTINUOUS_MAX_PUSHES		= 4;
+
+// Dynamic bodies slower than these for SLEEP_DELAY physics seconds, along with
+// everything they touch, are parked as static until something disturbs them
+constexpr float SLEEP_SPEED				= 0.05f;
+constexpr float SLEEP_ANGULAR_SPEED		= 1.0f;
+constexpr float SLEEP_DELAY				= 0.5f;
+
+// 64-bit FNV-1a
+constexpr uint64_t STATE_HASH_OFFSET	= 14695981039346656037ULL;
+constexpr uint64_t STATE_HASH_PRIME		= 1099511628211ULL;
+
+// Per island node while sleep is worked out; folded into the island's root node
+constexpr uint8_t ISLAND_MEMBER			= 1 << 0;
+constexpr uint8_t ISLAND_MOVING			= 1 << 1;
+constexpr uint8_t ISLAND_RESTLESS		= 1 << 2;
 
 //--------------------------------------------------------------------------
 /**
@@ -52,341 +90,2128 @@ Map::~Map()
 bool Map::Load( char const *filename )
 {
 	m_filename = filename;
-	tinyxml2::XMLDocument config;
-	config.LoadFile( filename );
-	XmlElement* root = config.RootElement();
-
-	if( root )
+	MapData data;
+	if( ReadMapFile( filename, data ) )
 	{
 		DeleteAllShapes();
-		m_endZone = ParseXmlAttribute( *root, "endZone", Vec2( 5.0f, 5.0f ) );
-
-		for( XmlElement* xmlShape = root->FirstChildElement( "shape" ); xmlShape != NULL; xmlShape = xmlShape->NextSiblingElement( "shape" ) )
-		{
-			XmlElement* rbEle = xmlShape->FirstChildElement( "rigidbody" );
-
-			float restitution		= ParseXmlAttribute( *rbEle, "restitution", 0.f );
-			float friction			= ParseXmlAttribute( *rbEle, "friction", 0.2f );
-			float mass				= ParseXmlAttribute( *rbEle, "mass", 1.0f );
-			float angularDrag		= ParseXmlAttribute( *rbEle, "angularDrag", 0.0f );
-			float drag				= ParseXmlAttribute( *rbEle, "drag", 0.5f );
-			float angularVel		= ParseXmlAttribute( *rbEle, "angularVelocity", 0.5f );
-
-
-			std::string xRestrcted			= ParseXmlAttribute( *rbEle, "xRestricted", "false" );
-			std::string yRestrcted			= ParseXmlAttribute( *rbEle, "yRestricted", "false" );
-			std::string rotRestrcted		= ParseXmlAttribute( *rbEle, "rotRestricted", "false" );
-
-			std::string type		= ParseXmlAttribute( *rbEle, "type", "static" );
-
+		BeginStreaming( std::move( data ) );
+		LoadRegionsAround( m_camera->m_focusPoint, UINT_MAX );
+	}
+	return FinishLoad();
+}
 
-			XmlElement* colEle = xmlShape->FirstChildElement( "collider" );
+//--------------------------------------------------------------------------
+/**
+* Save
+*/
+bool Map::Save( const char* filePath )
+{
+	MapData data;
+	CaptureMapData( data );
+	bool saved = WriteMapXml( filePath, data );
+	if( saved && m_filename == filePath )
+	{
+		// Respawns should now come back to what was just saved
+		SnapshotPristine();
+	}
+	return saved;
+}
 
-			float radius	= ParseXmlAttribute( *colEle, "radius", 1.0f );
-			Vec2 exstents	= ParseXmlAttribute( *colEle, "extents", Vec2::ONE );
-			Vec2 locCanter	= ParseXmlAttribute( *colEle, "locCenter", Vec2::ZERO );
-			Vec2 locRight	= ParseXmlAttribute( *colEle, "locRight", Vec2::RIGHT );
+//--------------------------------------------------------------------------
+/**
+* SaveAsync
+* Snapshots the shapes now and leaves the file write to the job's worker.
+*/
+void Map::SaveAsync( const char* filePath, MapSaveJob& job )
+{
+	MapData data;
+	CaptureMapData( data );
+	if( m_filename == filePath )
+	{
+		SnapshotPristine();
+	}
+	job.Start( filePath, std::move( data ) );
+}
 
-			XmlElement* transEle = xmlShape->FirstChildElement( "trans" );
+//--------------------------------------------------------------------------
+/**
+* LoadBinary
+*/
+bool Map::LoadBinary( char const* filePath )
+{
+	MapData data;
+	if( !ReadMapBinary( filePath, data ) )
+	{
+		return false;
+	}
 
-			Vec2 pos	= ParseXmlAttribute( *transEle, "pos", Vec2::ZERO );
-			Vec2 scale	= ParseXmlAttribute( *transEle, "scale", Vec2::ZERO );
-			float rot	= ParseXmlAttribute( *transEle, "rot", 0.0f );
-			std::string alignString	= ParseXmlAttribute( *transEle, "alignment", "neutral" );
-			eAlignment alignment	= GetAlignmentFromString( alignString );
+	DeleteAllShapes();
+	BeginStreaming( std::move( data ) );
+	LoadRegionsAround( m_camera->m_focusPoint, UINT_MAX );
+	return FinishLoad();
+}
 
+//--------------------------------------------------------------------------
+/**
+* SaveBinary
+*/
+bool Map::SaveBinary( char const* filePath ) const
+{
+	MapData data;
+	CaptureMapData( data );
+	return WriteMapBinary( filePath, data );
+}
 
-			Transform2D trans( pos, rot, scale );
-			Shape* shape = new Pill( trans, type == "dynamic" ? PHYSICS_SIM_DYNAMIC : PHYSICS_SIM_STATIC, alignment, exstents.x * 2.0f, exstents.y * 2.0f, radius, mass, restitution, friction, drag, angularDrag );
-			shape->m_rigidbody->SetAngularVelocity( angularVel );
-			shape->m_rigidbody->SetRestrictions( xRestrcted == "true", yRestrcted == "true", rotRestrcted == "true" );
-			if( alignment == ALIGNMENT_PLAYER )
-			{
-				m_player = shape;
-			}
-			AddShape( shape );
+//--------------------------------------------------------------------------
+/**
+* BeginLoadAsync
+* Reads the map on a worker; shapes are spawned over the following UpdateLoadAsync calls.
+*/
+void Map::BeginLoadAsync( char const* filename )
+{
+	m_filename = filename;
+	m_spawnIdx = 0;
+	m_spawning = false;
+	m_loadJob.Start( m_filename );
+}
 
+//--------------------------------------------------------------------------
+/**
+* UpdateLoadAsync
+* Returns true on the frame the map finishes loading.
+* Only the regions around the start are spawned; the rest stream in during play.
+*/
+bool Map::UpdateLoadAsync()
+{
+	if( !m_spawning )
+	{
+		if( !m_loadJob.IsFinished() )
+		{
+			return false;
 		}
+		m_loadJob.Join();
+		DeleteAllShapes();
+		MapData& data = m_loadJob.GetData();
+		if( !m_loadJob.Succeeded() )
+		{
+			data.m_shapes.clear();
+			data.m_regions.clear();
+		}
+		BeginStreaming( std::move( data ) );
+		m_loadJob.Reset();
 
-
-
+		m_spawning = true;
+		m_spawnIdx = 0;
+		m_spawnTotal = CountShapesAround( m_camera->m_focusPoint );
+		m_shapes.Reserve( m_spawnTotal );
+		m_shapeTables.Reserve( m_spawnTotal );
 	}
-	if( m_player )
+
+	uint numSpawned = LoadRegionsAround( m_camera->m_focusPoint, SHAPES_SPAWNED_PER_FRAME );
+	m_spawnIdx += numSpawned;
+	if( numSpawned > 0 && m_spawnIdx < m_spawnTotal )
 	{
-		m_camera->SetFocalPoint( m_player->GetPosition() );
+		return false;
 	}
-	else
+
+	m_spawning = false;
+	FinishLoad();
+	return true;
+}
+
+//--------------------------------------------------------------------------
+/**
+* CancelLoadAsync
+* Doesn't wait for a read in flight.
+*/
+void Map::CancelLoadAsync()
+{
+	if( IsLoadingAsync() )
 	{
-		m_camera->SetFocalPoint( Vec2( 1, 1 ) );
+		m_loadJob.Cancel();
+		m_spawning = false;
+		DeleteAllShapes();
 	}
-	m_hasLoaded = true;
-	return Create( 64, 64 );
 }
 
 //--------------------------------------------------------------------------
 /**
-* Save
+* IsLoadingAsync
 */
-bool Map::Save( const char* filePath )
+bool Map::IsLoadingAsync() const
 {
-	tinyxml2::XMLDocument config;
-	tinyxml2::XMLElement* root = config.NewElement("map");
-	config.InsertFirstChild( root );
-
-	root->SetAttribute( "mapDims", Stringf( "%f,%f", WORLD_WIDTH, WORLD_HEIGHT ).c_str() );
-	root->SetAttribute( "endZone", Stringf( "%f,%f", m_endZone.x, m_endZone.y ).c_str() );
+	return m_spawning || m_loadJob.IsStarted();
+}
 
-	for( unsigned int shapeIdx = 0; shapeIdx < ( unsigned int ) m_shapes.size(); ++shapeIdx )
+//--------------------------------------------------------------------------
+/**
+* GetLoadProgress
+* 0 while the worker is reading, then the fraction of the starting regions spawned.
+*/
+float Map::GetLoadProgress() const
+{
+	if( !m_spawning )
 	{
-		Shape* shape = m_shapes[shapeIdx];
-		if( shape )
-		{
-			tinyxml2::XMLElement* shapeEle = config.NewElement( "shape" );
-			root->InsertFirstChild( shapeEle );
-
-
-			tinyxml2::XMLElement* shapeRBEle = shape->m_rigidbody->GetAsXMLElement( &config );
-			shapeEle->InsertFirstChild( shapeRBEle );
-
-			tinyxml2::XMLElement* shapeColEle = shape->m_collider->GetAsXMLElemnt( &config );
-			shapeEle->InsertFirstChild( shapeColEle );
-
-			tinyxml2::XMLElement* shapeTransEle = config.NewElement( "trans" );
-			shapeEle->InsertFirstChild( shapeTransEle );
-
-			shapeTransEle->SetAttribute( "pos", Stringf( "%f,%f", shape->m_transform.m_position.x, shape->m_transform.m_position.y ).c_str() );
-			shapeTransEle->SetAttribute( "scale", Stringf( "%f,%f", shape->m_transform.m_scale.x, shape->m_transform.m_scale.y ).c_str() );
-			shapeTransEle->SetAttribute( "rot", Stringf( "%f", shape->m_transform.m_rotation ).c_str() );
-			shapeTransEle->SetAttribute( "alignment", Stringf( "%s", GetStringFromAlignment( shape->m_alignment ).c_str() ).c_str() );
-		}
+		return m_hasLoaded ? 1.0f : 0.0f;
 	}
+	return m_spawnTotal == 0 ? 1.0f : (float) m_spawnIdx / (float) m_spawnTotal;
+}
 
-	return config.SaveFile( filePath ) == tinyxml2::XML_SUCCESS;
+//--------------------------------------------------------------------------
+/**
+* SpawnShape
+*/
+Shape* Map::SpawnShape( const ShapeDefinition& definition )
+{
+	Shape* shape = m_pillPool.Create( definition );
+	ShapeHandle handle = AddShape( shape );
+	if( definition.m_alignment == ALIGNMENT_PLAYER )
+	{
+		m_player = handle;
+	}
+	return shape;
 }
 
 //--------------------------------------------------------------------------
 /**
-* Create
+* GetShapeDefinition
+* Authored definition with the live transform and rigidbody state laid over it.
 */
-bool Map::Create( int tileWidth, int tileHeight )
+ShapeDefinition Map::GetShapeDefinition( const Shape* shape ) const
 {
-	m_tileDimensions = IntVec2( tileWidth, tileHeight );
-	m_vertDimensions = IntVec2( 2 * tileWidth + 1, 2 * tileHeight + 1 );
-	return true;
+	ShapeDefinition def = shape->m_definition;
+	def.m_position			= shape->m_transform.m_position;
+	def.m_scale				= shape->m_transform.m_scale;
+	def.m_rotation			= shape->m_transform.m_rotation;
+	def.m_alignment			= shape->m_alignment;
+	def.m_angularVelocity	= shape->m_rigidbody->GetAngularVelocity();
+	def.m_xRestricted		= shape->m_rigidbody->IsXRestricted();
+	def.m_yRestricted		= shape->m_rigidbody->IsYRestricted();
+	def.m_rotRestricted		= shape->m_rigidbody->IsRotRestricted();
+	return def;
 }
 
-//------------------------	--------------------------------------------------
+//--------------------------------------------------------------------------
 /**
-* Update
+* CaptureMapData
+* The whole level: live shapes plus the parked state of unloaded regions.
+* outLiveShapes, if given, lines up with out.m_shapes (nullptr for parked ones).
 */
-void Map::Update( float deltaSec )
+void Map::CaptureMapData( MapData& out, std::vector<Shape*>* outLiveShapes ) const
 {
-	UpdatePlayerPosAndCamera( deltaSec );
- 	Vec3 mousePos = g_theGameController->GetWorldMousePos();
- 	DebugRenderMessage( 0.0f, Rgba::WHITE, Rgba::WHITE, "Mouse World Pos: %f, %f, %f", mousePos.x, mousePos.y, mousePos.z );
-	for( Shape* s : m_shapes )
+	std::vector<Shape*> liveShapes;
+	out.m_endZone = m_endZone;
+	out.m_regionSize = m_pristine.m_regionSize;
+	out.m_triggers = m_pristine.m_triggers;
+	out.m_shapes.clear();
+	out.m_shapes.reserve( m_streamShapes.size() + m_shapes.GetCount() );
+	for( const MapStreamShape& streamed : m_streamShapes )
+	{
+		if( !streamed.m_isLive && !streamed.m_isRemoved )
+		{
+			out.m_shapes.push_back( streamed.m_definition );
+			liveShapes.push_back( nullptr );
+		}
+	}
+	for( Shape* shape : m_shapes )
+	{
+		out.m_shapes.push_back( GetShapeDefinition( shape ) );
+		liveShapes.push_back( shape );
+	}
+
+	std::vector<uint> order;
+	BuildMapRegions( out, &order );
+	if( outLiveShapes )
 	{
-		if( s )
+		outLiveShapes->resize( order.size() );
+		for( uint shapeIdx = 0; shapeIdx < (uint) order.size(); ++shapeIdx )
 		{
-			s->Update( deltaSec );
+			(*outLiveShapes)[shapeIdx] = liveShapes[order[shapeIdx]];
 		}
 	}
-	if( m_player->IsAlive() && m_player->m_collider->IsColliding() )
+}
+
+//--------------------------------------------------------------------------
+/**
+* SnapshotPristine
+* Live shapes are rehomed to the region they now sit in; any region that ends up
+* holding one is treated as loaded.
+*/
+void Map::SnapshotPristine()
+{
+	std::vector<Shape*> liveShapes;
+	CaptureMapData( m_pristine, &liveShapes );
+	ResetStreamState();
+
+	for( uint regionIdx = 0; regionIdx < (uint) m_pristine.m_regions.size(); ++regionIdx )
 	{
-		m_player->m_preventInputTimer->Reset();
-		m_player->m_health -= m_player->GetCollisionDamage();
-		m_player->m_transform.m_scale = Vec2( m_player->m_health, m_player->m_health );
-		if( m_player->m_health < .5f )
+		const MapRegion& region = m_pristine.m_regions[regionIdx];
+		for( uint shapeIdx = region.m_firstShape; shapeIdx < region.m_firstShape + region.m_numShapes; ++shapeIdx )
 		{
-			Load( m_filename.c_str() );
+			Shape* shape = liveShapes[shapeIdx];
+			if( shape )
+			{
+				shape->m_pristineIdx = (int) shapeIdx;
+				shape->m_regionIdx = (int) regionIdx;
+				m_streamShapes[shapeIdx].m_isLive = true;
+				m_regionLoaded[regionIdx] = true;
+			}
 		}
 	}
-	if( ( m_player->GetPosition() - m_endZone ).GetLength() < m_endZoneRadius )
+
+	// A loaded region can't have parked shapes
+	for( uint regionIdx = 0; regionIdx < (uint) m_regionLoaded.size(); ++regionIdx )
 	{
-		g_theGame->LoadNextMap();
+		if( m_regionLoaded[regionIdx] )
+		{
+			LoadRegion( regionIdx );
+		}
 	}
-	GarbageCollection();
 }
 
 //--------------------------------------------------------------------------
 /**
-* Render
+* Respawn
+* Puts the map back the way it was loaded from the in-memory snapshot.
+* Shapes that still exist are reset in place; only missing ones are rebuilt.
+* Regions are reloaded around the start, so anything further off is dropped.
 */
-void Map::Render() const
+void Map::Respawn()
 {
-	std::vector<Vertex_PCU> verts;
-	AddVertsForRing2D( verts, m_endZone, m_endZoneRadius, 0.05f, Rgba::YELLOW, 6 );
-	g_theRenderer->DrawVertexArray( verts );
-	for( Shape* s : m_shapes )
+	g_theGame->DeselectShape();
+	m_areContactsStale = true;
+
+	ResetStreamState();
+	Vec2 startFocus = GetStartFocus();
+	for( uint regionIdx = 0; regionIdx < (uint) m_regionLoaded.size(); ++regionIdx )
+	{
+		m_regionLoaded[regionIdx] = GetDistanceToRegion( regionIdx, startFocus ) <= REGION_LOAD_DISTANCE;
+	}
+
+	// Match live shapes to their snapshot entry; anything not from the file or out of range goes
+	m_respawnScratch.assign( m_pristine.m_shapes.size(), nullptr );
+	for( uint denseIdx = m_shapes.GetCount(); denseIdx-- > 0; )
+	{
+		Shape* s = m_shapes[denseIdx];
+		if( s->m_pristineIdx >= 0 && s->m_pristineIdx < (int) m_respawnScratch.size() && !m_respawnScratch[s->m_pristineIdx]
+			&& s->m_regionIdx >= 0 && m_regionLoaded[s->m_regionIdx] )
+		{
+			m_respawnScratch[s->m_pristineIdx] = s;
+		}
+		else
+		{
+			RemoveShape( s );
+		}
+	}
+
+	m_player = ShapeHandle::INVALID;
+	m_destroyQueue.clear();
+
+	// Contacts start over; the next step reports everything touching as begun
+	m_contactEvents.clear();
+	m_prevContactRecords.clear();
+	m_numEventSteps = 0;
+	if( m_endZone.x != m_pristine.m_endZone.x || m_endZone.y != m_pristine.m_endZone.y )
+	{
+		SetEndZone( m_pristine.m_endZone );
+	}
+	for( uint shapeIdx = 0; shapeIdx < (uint) m_pristine.m_shapes.size(); ++shapeIdx )
+	{
+		Shape* shape = m_respawnScratch[shapeIdx];
+		if( shape )
+		{
+			const ShapeDefinition& def = m_pristine.m_shapes[shapeIdx];
+			shape->ResetToDefinition( def );
+			uint denseIdx = m_shapes.GetDenseIndex( shape->m_handle );
+			if( m_shapeTables.HasFlag( denseIdx, SHAPE_FLAG_ASLEEP ) )
+			{
+				SetAsleep( denseIdx, false );
+			}
+			m_shapeTables.m_flags[denseIdx] = 0;
+			m_shapeTables.m_numContacts[denseIdx] = 0;
+			m_shapeTables.ResetTriggerState( denseIdx );
+			WriteShapeState( denseIdx );
+			UpdateShapeCell( denseIdx );
+			m_shapeTables.SnapPreviousState( denseIdx );
+			m_streamShapes[shapeIdx].m_isLive = true;
+			if( def.m_alignment == ALIGNMENT_PLAYER )
+			{
+				m_player = shape->m_handle;
+			}
+		}
+	}
+	for( uint regionIdx = 0; regionIdx < (uint) m_regionLoaded.size(); ++regionIdx )
 	{
-		if( s )
+		if( m_regionLoaded[regionIdx] )
 		{
-			s->Render();
+			LoadRegion( regionIdx );
 		}
 	}
+
+	// Regions around the start still load; streaming catches up around the checkpoint
+	Shape* player = GetPlayer();
+	if( player && m_hasCheckpoint && player->m_pristineIdx >= 0 )
+	{
+		ShapeDefinition def = m_pristine.m_shapes[player->m_pristineIdx];
+		def.m_position = m_checkpoint;
+		player->ResetToDefinition( def );
+		uint denseIdx = m_shapes.GetDenseIndex( player->m_handle );
+		WriteShapeState( denseIdx );
+		UpdateShapeCell( denseIdx );
+		m_shapeTables.SnapPreviousState( denseIdx );
+	}
+	if( player )
+	{
+		m_camera->SetFocalPoint( player->GetPosition() );
+	}
 }
 
 //--------------------------------------------------------------------------
 /**
-* IsLoaded
+* GetNumLoadedRegions
 */
-bool Map::IsLoaded() const
+uint Map::GetNumLoadedRegions() const
 {
-	return m_hasLoaded;
+	return (uint) std::count( m_regionLoaded.begin(), m_regionLoaded.end(), true );
 }
 
 //--------------------------------------------------------------------------
 /**
-* GetXYBounds
+* BeginStreaming
+* Takes over freshly read map data. No shapes are spawned yet.
 */
-AABB2 Map::GetXYBounds() const
+void Map::BeginStreaming( MapData&& data )
 {
-	return AABB2( (float) m_tileDimensions.x, (float) m_tileDimensions.y, Vec2( (float) m_tileDimensions.x * .5f, (float) m_tileDimensions.y * .5f ) );
+	m_pristine = std::move( data );
+	m_endZone = m_pristine.m_endZone;
+	m_hasCheckpoint = false;
+	RebuildTriggerField();
+	ResetStreamState();
+	m_camera->SetFocalPoint( GetStartFocus() );
 }
 
 //--------------------------------------------------------------------------
 /**
-* RenderTerrain
+* ResetStreamState
+* Every shape back to its pristine definition, nothing live, no region loaded.
 */
-void Map::RenderTerrain( Material* matOverride /*= nullptr */ ) const
+void Map::ResetStreamState()
 {
-	if( matOverride )
-	{
-		m_renderContext->BindMaterial( matOverride );
-	}
-	else
+	m_streamShapes.resize( m_pristine.m_shapes.size() );
+	for( uint shapeIdx = 0; shapeIdx < (uint) m_streamShapes.size(); ++shapeIdx )
 	{
-		m_renderContext->BindMaterial( m_terrainMaterial );
+		MapStreamShape& streamed = m_streamShapes[shapeIdx];
+		streamed.m_definition = m_pristine.m_shapes[shapeIdx];
+		streamed.m_isLive = false;
+		streamed.m_isRemoved = false;
 	}
-	m_renderContext->DrawMesh( m_terrainMesh );
+	m_regionLoaded.assign( m_pristine.m_regions.size(), false );
 }
 
 //--------------------------------------------------------------------------
 /**
-* GenerateTerrainMesh
+* UpdateStreaming
 */
-void Map::GenerateTerrainMesh()
+void Map::UpdateStreaming()
 {
-	MeshCPU plane;
-	AABB2 bounds = GetXYBounds();
-
-	// Push all verts into plane.
-	float v = (float) m_vertDimensions.y;
-	for( unsigned int hIdx = 0; hIdx < (unsigned int) m_vertDimensions.y; ++hIdx )
+	Vec2 focus = m_camera->m_focusPoint;
+	for( uint regionIdx = 0; regionIdx < (uint) m_regionLoaded.size(); ++regionIdx )
 	{
-		float u = 0.0f;
-		for( unsigned int wInt = 0; wInt < (unsigned int) m_vertDimensions.x; ++wInt )
+		if( m_regionLoaded[regionIdx] && GetDistanceToRegion( regionIdx, focus ) > REGION_LOAD_DISTANCE + REGION_UNLOAD_MARGIN )
 		{
-			VertexMaster vertToAdd;
-			
-			vertToAdd.position	= Vec3( -.5f + (float) wInt * .5f, -.5f + (float) hIdx * .5f, .1f );
-			vertToAdd.normal	= Vec3( 0.0f, 0.0f, -1.0f );
-			vertToAdd.tangent	= Vec4( 1.0f, 0.0f, 0.0f, 1.0f );			
-			vertToAdd.uv		= Vec2( u, v );
-
-			plane.AddVertex( vertToAdd );
-			u += .5f;
+			UnloadRegion( regionIdx );
 		}
-		v -= .5f;
 	}
+	LoadRegionsAround( focus, SHAPES_SPAWNED_PER_FRAME );
+}
 
-	for( unsigned int hIdx = 0; hIdx < (unsigned int) m_tileDimensions.y * 2; ++hIdx )
+//--------------------------------------------------------------------------
+/**
+* LoadRegionsAround
+* Loads whole regions in range of focus until maxToSpawn is used up. Returns the number of shapes spawned.
+*/
+uint Map::LoadRegionsAround( const Vec2& focus, uint maxToSpawn )
+{
+	uint numSpawned = 0;
+	for( uint regionIdx = 0; regionIdx < (uint) m_regionLoaded.size() && numSpawned < maxToSpawn; ++regionIdx )
 	{
-		for( unsigned int wInt = 0; wInt < (unsigned int) m_tileDimensions.x * 2; ++wInt )
+		if( !m_regionLoaded[regionIdx] && GetDistanceToRegion( regionIdx, focus ) <= REGION_LOAD_DISTANCE )
 		{
-			plane.AddIndexedTriangle( GetVertIndex( wInt, hIdx ), GetVertIndex( wInt + 1, hIdx ), GetVertIndex( wInt + 1, hIdx + 1 ) );
-			plane.AddIndexedTriangle( GetVertIndex( wInt, hIdx ), GetVertIndex( wInt + 1, hIdx + 1 ), GetVertIndex( wInt, hIdx + 1 ) );
+			numSpawned += LoadRegion( regionIdx );
 		}
 	}
-	SAFE_DELETE( m_terrainMesh );
-	m_terrainMesh = new MeshGPU( g_theRenderer );
-	m_terrainMesh->CreateFromCPUMesh<Vertex_LIT>( &plane );
+	return numSpawned;
 }
 
 //--------------------------------------------------------------------------
 /**
-* GetVertIndex
+* CountShapesAround
+* How many shapes LoadRegionsAround would spawn for focus with no limit.
 */
-int Map::GetVertIndex( int x, int y )
+uint Map::CountShapesAround( const Vec2& focus ) const
 {
-	return x + y * m_vertDimensions.x;
+	uint numShapes = 0;
+	for( uint regionIdx = 0; regionIdx < (uint) m_regionLoaded.size(); ++regionIdx )
+	{
+		if( !m_regionLoaded[regionIdx] && GetDistanceToRegion( regionIdx, focus ) <= REGION_LOAD_DISTANCE )
+		{
+			numShapes += m_pristine.m_regions[regionIdx].m_numShapes;
+		}
+	}
+	return numShapes;
 }
 
 //--------------------------------------------------------------------------
 /**
-* GarbageCollection
+* LoadRegion
+* Spawns the region's parked shapes from their last known state.
 */
-void Map::GarbageCollection()
+uint Map::LoadRegion( uint regionIdx )
 {
-	for( Shape*& s : m_shapes )
+	const MapRegion& region = m_pristine.m_regions[regionIdx];
+	m_regionLoaded[regionIdx] = true;
+
+	m_batchDefinitions.clear();
+	m_batchIndices.clear();
+	for( uint shapeIdx = region.m_firstShape; shapeIdx < region.m_firstShape + region.m_numShapes; ++shapeIdx )
 	{
-		if( s && s->m_isGarbage )
+		const MapStreamShape& streamed = m_streamShapes[shapeIdx];
+		if( !streamed.m_isLive && !streamed.m_isRemoved )
 		{
-			if( s == g_theGame->m_selectedShape )
-			{
-				g_theGame->DeselectShape();
-			}
-			if( s == m_player )
-			{
-				m_player = nullptr;
-			}
-			RemoveShape( s );
+			m_batchDefinitions.push_back( streamed.m_definition );
+			m_batchIndices.push_back( shapeIdx );
 		}
 	}
+
+	m_batchShapes.clear();
+	AddShapes( m_batchDefinitions.data(), (uint) m_batchDefinitions.size(), m_batchShapes );
+	for( uint batchIdx = 0; batchIdx < (uint) m_batchShapes.size(); ++batchIdx )
+	{
+		Shape* shape = m_batchShapes[batchIdx];
+		shape->m_pristineIdx = (int) m_batchIndices[batchIdx];
+		shape->m_regionIdx = (int) regionIdx;
+		m_streamShapes[m_batchIndices[batchIdx]].m_isLive = true;
+	}
+	return (uint) m_batchShapes.size();
 }
 
 //--------------------------------------------------------------------------
 /**
-* DeleteAllShapes
+* UnloadRegion
+* Parks the state of the region's shapes and frees them. Shapes stay with the region
+* they were loaded in; the player and the selected shape are never unloaded.
 */
-void Map::DeleteAllShapes()
+void Map::UnloadRegion( uint regionIdx )
 {
-	m_hasLoaded = false;
-	for( Shape* s: m_shapes )
+	m_regionLoaded[regionIdx] = false;
+	for( uint denseIdx = m_shapes.GetCount(); denseIdx-- > 0; )
 	{
-		if( s )
+		Shape* s = m_shapes[denseIdx];
+		if( s->m_regionIdx != (int) regionIdx || s->m_handle == m_player || s->m_handle == g_theGame->m_selectedShape )
 		{
-			if( s == m_player )
-			{
-				m_player = nullptr;
-			}
-			SAFE_DELETE(s);
+			continue;
 		}
+		MapStreamShape& streamed = m_streamShapes[s->m_pristineIdx];
+		streamed.m_definition = GetShapeDefinition( s );
+		streamed.m_isLive = false;
+		RemoveShape( s );
 	}
-	m_shapes.clear();
 }
 
 //--------------------------------------------------------------------------
 /**
-* AddShape
+* GetDistanceToRegion
+*/
+float Map::GetDistanceToRegion( uint regionIdx, const Vec2& point ) const
+{
+	const MapRegion& region = m_pristine.m_regions[regionIdx];
+	float regionSize = m_pristine.m_regionSize;
+	Vec2 mins = Vec2( (float) region.m_coords.x * regionSize, (float) region.m_coords.y * regionSize );
+	Vec2 maxs = mins + Vec2( regionSize, regionSize );
+
+	Vec2 outside;
+	outside.x = std::max( std::max( mins.x - point.x, point.x - maxs.x ), 0.0f );
+	outside.y = std::max( std::max( mins.y - point.y, point.y - maxs.y ), 0.0f );
+	return outside.GetLength();
+}
+
+//--------------------------------------------------------------------------
+/**
+* GetStartFocus
 */
-void Map::AddShape( Shape* shape )
+Vec2 Map::GetStartFocus() const
 {
-	for( Shape*& s : m_shapes )
+	for( const ShapeDefinition& def : m_pristine.m_shapes )
 	{
-		if( !s )
+		if( def.m_alignment == ALIGNMENT_PLAYER )
 		{
-			s = shape;
-			return;
+			return def.m_position;
 		}
 	}
-	m_shapes.push_back( shape );
+	return Vec2( 1, 1 );
 }
 
 //--------------------------------------------------------------------------
 /**
-* RemoveShape
+* FinishLoad
 */
-void Map::RemoveShape( Shape* shape )
+bool Map::FinishLoad()
 {
-	for( Shape*& s : m_shapes )
+	Shape* player = GetPlayer();
+	if( player )
 	{
-		if( s && shape == s )
-		{
-			delete s;
-			s = nullptr;
-			return;
-		}
+		m_camera->SetFocalPoint( player->GetPosition() );
+	}
+	else
+	{
+		m_camera->SetFocalPoint( Vec2( 1, 1 ) );
+	}
+	m_hasLoaded = true;
+	Vec2 dims = GetMapDimensions( m_pristine );
+	return Create( (int) ceilf( dims.x ), (int) ceilf( dims.y ) );
+}
+
+//--------------------------------------------------------------------------
+/**
+* Create
+*/
+bool Map::Create( int tileWidth, int tileHeight )
+{
+	m_tileDimensions = IntVec2( tileWidth, tileHeight );
+	m_vertDimensions = IntVec2( 2 * tileWidth + 1, 2 * tileHeight + 1 );
+	return true;
+}
+
+//------------------------	--------------------------------------------------
+/**
+* Update
+*/
+void Map::Update( float deltaSec )
+{
+	UpdatePlayerPosAndCamera( deltaSec );
+ 	Vec3 mousePos = g_theGameController->GetWorldMousePos();
+ 	DebugRenderMessage( 0.0f, Rgba::WHITE, Rgba::WHITE, "Mouse World Pos: %f, %f, %f", mousePos.x, mousePos.y, mousePos.z );
+	DestroyQueuedShapes();
+	UpdateStreaming();
+
+	// Damage can respawn the level, which moves rows and bodies under the contacts
+	ProcessContactEvents();
+	GatherShapeState();
+
+	// Contacts are found at the end of every physics step; sleeping only needs a
+	// fresh pass here when rows have moved since
+	if( m_areContactsStale )
+	{
+		FindContacts();
+	}
+	UpdateSleeping( (float) g_theApp->m_physicsSteps->GetStepsThisFrame() * g_theApp->m_physicsSteps->GetStepSeconds() );
+	UpdateTriggers( deltaSec );
+	if( m_isShowingStats )
+	{
+		uint numShapes = GetNumShapes();
+		uint64_t numUnprunedPairs = (uint64_t) numShapes * ( numShapes > 0 ? numShapes - 1 : 0 ) / 2;
+		DebugRenderMessage( 0.0f, Rgba::WHITE, Rgba::WHITE, "Contacts: %u of %u candidate pairs (%u shapes, %llu pairs unpruned)"
+			, (uint) m_contacts.size(), (uint) m_broadphase.GetCandidates().size(), numShapes, (unsigned long long) numUnprunedPairs );
+		DebugRenderMessage( 0.0f, Rgba::WHITE, Rgba::WHITE, "Contact events: %u over %u steps", (uint) m_contactEvents.size(), m_numEventSteps );
+		DebugRenderMessage( 0.0f, Rgba::WHITE, Rgba::WHITE, "Asleep: %u of %u shapes", m_numAsleep, numShapes );
+		DebugRenderMessage( 0.0f, Rgba::WHITE, Rgba::WHITE, "Continuous collision: %u bodies, %u hits this frame", (uint) m_continuousBodies.size(), m_numContinuousHits );
+		DebugRenderMessage( 0.0f, Rgba::WHITE, Rgba::WHITE, "Kinematic: %u bodies, %u pushes this frame", (uint) m_kinematicBodies.size(), m_numKinematicPushes );
+		if( m_isDeterministic )
+		{
+			DebugRenderMessage( 0.0f, Rgba::WHITE, Rgba::WHITE, "Deterministic: last step hash %016llx", (unsigned long long) m_lastStepHash );
+		}
+		DebugRenderMessage( 0.0f, Rgba::WHITE, Rgba::WHITE, "Regions: %u/%u loaded", GetNumLoadedRegions(), (uint) m_regionLoaded.size() );
+	}
+	m_contactEvents.clear();
+	m_numEventSteps = 0;
+	m_numContinuousHits = 0;
+	m_numKinematicPushes = 0;
+}
+
+//--------------------------------------------------------------------------
+/**
+* Render
+*/
+void Map::Render() const
+{
+	RenderTriggers();
+	RenderShapes();
+}
+
+//--------------------------------------------------------------------------
+/**
+* RenderShapes
+* Builds every shape from the packed tables into one vertex array and draws it once.
+* Shapes are drawn between their last two physics states by how far time is toward the next step.
+*/
+void Map::RenderShapes() const
+{
+	m_shapeVerts.clear();
+	float blend = g_theApp->m_physicsSteps->GetInterpolation();
+	uint numShapes = m_shapeTables.GetCount();
+	for( uint rowIdx = 0; rowIdx < numShapes; ++rowIdx )
+	{
+		const Rgba& boarderColor = m_shapeTables.HasFlag( rowIdx, SHAPE_FLAG_SELECTED ) ? Rgba::WHITE : m_shapeTables.m_borderColors[rowIdx];
+		AddVertsForPill2D( m_shapeVerts, m_shapeTables.m_prevWorldShapes[rowIdx], m_shapeTables.m_worldShapes[rowIdx], blend
+			, m_shapeTables.m_fillColors[rowIdx], boarderColor );
+	}
+	if( !m_shapeVerts.empty() )
+	{
+		g_theRenderer->BindTextureView( 0, nullptr );
+		g_theRenderer->DrawVertexArray( m_shapeVerts );
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* SetEndZone
+*/
+void Map::SetEndZone( const Vec2& position )
+{
+	m_endZone = position;
+	RebuildTriggerField();
+}
+
+//--------------------------------------------------------------------------
+/**
+* RebuildTriggerField
+* Files the end zone and the level's triggers; every shape is tested afresh next frame.
+*/
+void Map::RebuildTriggerField()
+{
+	std::vector<TriggerDefinition> triggers;
+	triggers.reserve( m_pristine.m_triggers.size() + 1 );
+	triggers.emplace_back();
+	triggers.back().m_type = TRIGGER_END_ZONE;
+	triggers.back().m_center = m_endZone;
+	triggers.back().m_radius = m_endZoneRadius;
+	triggers.insert( triggers.end(), m_pristine.m_triggers.begin(), m_pristine.m_triggers.end() );
+	m_triggerField.Build( triggers.data(), (uint) triggers.size() );
+
+	for( uint rowIdx = 0; rowIdx < m_shapeTables.GetCount(); ++rowIdx )
+	{
+		m_shapeTables.ResetTriggerState( rowIdx );
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* UpdateTriggers
+* Only shapes whose center moved since they were last tested look in the field,
+* so the cost follows the moving shapes rather than the number of triggers.
+*/
+void Map::UpdateTriggers( float deltaSec )
+{
+	m_triggerEvents.clear();
+	uint numShapes = m_shapeTables.GetCount();
+	for( uint rowIdx = 0; rowIdx < numShapes; ++rowIdx )
+	{
+		const Vec2& center = m_shapeTables.m_worldShapes[rowIdx].m_obb.m_center;
+		Vec2& testPos = m_shapeTables.m_triggerTestPos[rowIdx];
+		if( center.x == testPos.x && center.y == testPos.y )
+		{
+			continue;
+		}
+		testPos = center;
+
+		m_triggerScratch.clear();
+		m_triggerField.GatherAt( center, m_triggerScratch );
+		std::vector<uint>& contacts = m_shapeTables.m_triggerContacts[rowIdx];
+		if( m_triggerScratch == contacts )
+		{
+			continue;
+		}
+
+		// Both lists are ascending, so one walk finds what was left and what was entered
+		ShapeHandle handle = m_shapes[rowIdx]->m_handle;
+		size_t oldIdx = 0;
+		size_t newIdx = 0;
+		while( oldIdx < contacts.size() || newIdx < m_triggerScratch.size() )
+		{
+			if( newIdx == m_triggerScratch.size() || ( oldIdx < contacts.size() && contacts[oldIdx] < m_triggerScratch[newIdx] ) )
+			{
+				m_triggerEvents.push_back( { handle, contacts[oldIdx++], false } );
+			}
+			else if( oldIdx == contacts.size() || m_triggerScratch[newIdx] < contacts[oldIdx] )
+			{
+				m_triggerEvents.push_back( { handle, m_triggerScratch[newIdx++], true } );
+			}
+			else
+			{
+				++oldIdx;
+				++newIdx;
+			}
+		}
+		contacts.swap( m_triggerScratch );
+	}
+
+	// None of the trigger types act on leaving yet
+	for( const TriggerEvent& event: m_triggerEvents )
+	{
+		Shape* shape = m_shapes.Get( event.m_shape );
+		if( !shape || !event.m_isEnter )
+		{
+			continue;
+		}
+		const TriggerDefinition& trigger = m_triggerField.GetTrigger( event.m_trigger );
+		bool isPlayer = event.m_shape == m_player;
+		switch( trigger.m_type )
+		{
+		case TRIGGER_END_ZONE:
+			if( isPlayer )
+			{
+				g_theGame->LoadNextMap();
+				return;
+			}
+			break;
+		case TRIGGER_CHECKPOINT:
+			if( isPlayer )
+			{
+				m_checkpoint = trigger.m_center;
+				m_hasCheckpoint = true;
+			}
+			break;
+		case TRIGGER_SPEED:
+			if( shape->m_rigidbody->GetSimulationType() == PHYSICS_SIM_DYNAMIC )
+			{
+				shape->m_rigidbody->SetVelocity( shape->m_rigidbody->GetVelocity() * trigger.m_value );
+			}
+			break;
+		case TRIGGER_KILL:
+			if( isPlayer )
+			{
+				Respawn();
+				return;
+			}
+			QueueDestroy( event.m_shape );
+			break;
+		default:
+			break;
+		}
+	}
+
+	// Damage fields hurt every frame the player is inside, moving or not
+	uint playerIdx = m_shapes.GetDenseIndex( m_player );
+	if( playerIdx < numShapes )
+	{
+		float damage = 0.0f;
+		for( uint triggerIdx: m_shapeTables.m_triggerContacts[playerIdx] )
+		{
+			const TriggerDefinition& trigger = m_triggerField.GetTrigger( triggerIdx );
+			if( trigger.m_type == TRIGGER_DAMAGE )
+			{
+				damage += trigger.m_value * deltaSec;
+			}
+		}
+		if( damage > 0.0f )
+		{
+			DamagePlayer( damage );
+		}
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* DamagePlayer
+* Shrinks the player with its health; returns true if that respawned the map.
+*/
+bool Map::DamagePlayer( float damage )
+{
+	Shape* player = GetPlayer();
+	if( !player )
+	{
+		return false;
+	}
+	player->m_health -= damage;
+	player->m_transform.m_scale = Vec2( player->m_health, player->m_health );
+	if( player->m_health < .5f )
+	{
+		Respawn();
+		return true;
+	}
+	return false;
+}
+
+//--------------------------------------------------------------------------
+// Helper
+static Rgba GetTriggerColor( eTriggerType type )
+{
+	switch( type )
+	{
+	case TRIGGER_END_ZONE:		return Rgba::YELLOW;
+	case TRIGGER_CHECKPOINT:	return Rgba::GREEN;
+	case TRIGGER_DAMAGE:		return Rgba::LIGHT_RED;
+	case TRIGGER_SPEED:			return Rgba::CYAN;
+	case TRIGGER_KILL:			return Rgba::DARK_RED;
+	default:					return Rgba::WHITE;
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* RenderTriggers
+* Only triggers filed near the camera are drawn.
+*/
+void Map::RenderTriggers() const
+{
+	Vec2 reach = Vec2( REGION_LOAD_DISTANCE, REGION_LOAD_DISTANCE );
+	m_triggerScratch.clear();
+	m_triggerField.GatherBox( m_camera->m_focusPoint - reach, m_camera->m_focusPoint + reach, m_triggerScratch );
+
+	std::vector<Vertex_PCU> verts;
+	for( uint triggerIdx: m_triggerScratch )
+	{
+		const TriggerDefinition& trigger = m_triggerField.GetTrigger( triggerIdx );
+		AddVertsForRing2D( verts, trigger.m_center, trigger.m_radius, 0.05f, GetTriggerColor( trigger.m_type ), 6 );
+	}
+	if( !verts.empty() )
+	{
+		g_theRenderer->DrawVertexArray( verts );
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* IsLoaded
+*/
+bool Map::IsLoaded() const
+{
+	return m_hasLoaded;
+}
+
+//--------------------------------------------------------------------------
+/**
+* GetXYBounds
+*/
+AABB2 Map::GetXYBounds() const
+{
+	return AABB2( (float) m_tileDimensions.x, (float) m_tileDimensions.y, Vec2( (float) m_tileDimensions.x * .5f, (float) m_tileDimensions.y * .5f ) );
+}
+
+//--------------------------------------------------------------------------
+/**
+* RenderTerrain
+*/
+void Map::RenderTerrain( Material* matOverride /*= nullptr */ ) const
+{
+	if( matOverride )
+	{
+		m_renderContext->BindMaterial( matOverride );
+	}
+	else
+	{
+		m_renderContext->BindMaterial( m_terrainMaterial );
+	}
+	m_renderContext->DrawMesh( m_terrainMesh );
+}
+
+//--------------------------------------------------------------------------
+/**
+* GenerateTerrainMesh
+*/
+void Map::GenerateTerrainMesh()
+{
+	MeshCPU plane;
+	AABB2 bounds = GetXYBounds();
+
+	// Push all verts into plane.
+	float v = (float) m_vertDimensions.y;
+	for( unsigned int hIdx = 0; hIdx < (unsigned int) m_vertDimensions.y; ++hIdx )
+	{
+		float u = 0.0f;
+		for( unsigned int wInt = 0; wInt < (unsigned int) m_vertDimensions.x; ++wInt )
+		{
+			VertexMaster vertToAdd;
+			
+			vertToAdd.position	= Vec3( -.5f + (float) wInt * .5f, -.5f + (float) hIdx * .5f, .1f );
+			vertToAdd.normal	= Vec3( 0.0f, 0.0f, -1.0f );
+			vertToAdd.tangent	= Vec4( 1.0f, 0.0f, 0.0f, 1.0f );			
+			vertToAdd.uv		= Vec2( u, v );
+
+			plane.AddVertex( vertToAdd );
+			u += .5f;
+		}
+		v -= .5f;
+	}
+
+	for( unsigned int hIdx = 0; hIdx < (unsigned int) m_tileDimensions.y * 2; ++hIdx )
+	{
+		for( unsigned int wInt = 0; wInt < (unsigned int) m_tileDimensions.x * 2; ++wInt )
+		{
+			plane.AddIndexedTriangle( GetVertIndex( wInt, hIdx ), GetVertIndex( wInt + 1, hIdx ), GetVertIndex( wInt + 1, hIdx + 1 ) );
+			plane.AddIndexedTriangle( GetVertIndex( wInt, hIdx ), GetVertIndex( wInt + 1, hIdx + 1 ), GetVertIndex( wInt, hIdx + 1 ) );
+		}
+	}
+	SAFE_DELETE( m_terrainMesh );
+	m_terrainMesh = new MeshGPU( g_theRenderer );
+	m_terrainMesh->CreateFromCPUMesh<Vertex_LIT>( &plane );
+}
+
+//--------------------------------------------------------------------------
+/**
+* GetVertIndex
+*/
+int Map::GetVertIndex( int x, int y )
+{
+	return x + y * m_vertDimensions.x;
+}
+
+//--------------------------------------------------------------------------
+/**
+* QueueDestroy
+* The shape stays live until DestroyQueuedShapes; queuing it twice is harmless.
+*/
+void Map::QueueDestroy( ShapeHandle handle )
+{
+	uint denseIdx = m_shapes.GetDenseIndex( handle );
+	if( denseIdx >= m_shapeTables.GetCount() || m_shapeTables.HasFlag( denseIdx, SHAPE_FLAG_GARBAGE ) )
+	{
+		return;
+	}
+	m_shapeTables.SetFlag( denseIdx, SHAPE_FLAG_GARBAGE, true );
+	m_destroyQueue.push_back( handle );
+}
+
+//--------------------------------------------------------------------------
+/**
+* DestroyQueuedShapes
+* Frees everything queued since the last call and drops references to it.
+*/
+void Map::DestroyQueuedShapes()
+{
+	for( ShapeHandle handle: m_destroyQueue )
+	{
+		Shape* s = m_shapes.Get( handle );
+		if( !s )
+		{
+			continue;
+		}
+		if( handle == g_theGame->m_selectedShape )
+		{
+			g_theGame->DeselectShape();
+		}
+		if( handle == m_player )
+		{
+			m_player = ShapeHandle::INVALID;
+		}
+		if( s->m_pristineIdx >= 0 && s->m_pristineIdx < (int) m_streamShapes.size() )
+		{
+			m_streamShapes[s->m_pristineIdx].m_isLive = false;
+			m_streamShapes[s->m_pristineIdx].m_isRemoved = true;
+		}
+		RemoveShape( s );
+	}
+	m_destroyQueue.clear();
+}
+
+//--------------------------------------------------------------------------
+/**
+* GatherShapeState
+* Pulls what physics moved this frame into the tables in one pass.
+*/
+void Map::GatherShapeState()
+{
+	uint numShapes = m_shapes.GetCount();
+	for( uint denseIdx = 0; denseIdx < numShapes; ++denseIdx )
+	{
+		WriteShapeState( denseIdx );
+		UpdateShapeCell( denseIdx );
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* CapturePreviousShapeState
+* Reads the colliders as they stand before the frame's last physics step.
+*/
+void Map::CapturePreviousShapeState()
+{
+	uint numShapes = m_shapes.GetCount();
+	for( uint denseIdx = 0; denseIdx < numShapes; ++denseIdx )
+	{
+		m_shapeTables.m_prevWorldShapes[denseIdx] = static_cast<const PillboxCollider2D*>( m_shapes[denseIdx]->m_collider )->GetWorldShape();
+	}
+}
+
+//--------------------------------------------------------------------------
+// Helper
+static bool IsMovable( const Shape* shape )
+{
+	return shape->m_rigidbody->GetSimulationType() == PHYSICS_SIM_DYNAMIC
+		&& !( shape->m_rigidbody->IsXRestricted() && shape->m_rigidbody->IsYRestricted() );
+}
+
+//--------------------------------------------------------------------------
+// Helper
+// Half the pillbox's narrowest width; a step moving less than this can't tunnel
+static float GetPillboxHalfThickness( const Pillbox2& pill )
+{
+	return std::min( pill.m_obb.m_extents.x, pill.m_obb.m_extents.y ) + pill.m_radius;
+}
+
+//--------------------------------------------------------------------------
+/**
+* BeginPhysicsStep
+* Records every body's velocity and where every continuous collision body starts
+* the step, and wakes any sleeper a moving body could reach during it.
+*/
+void Map::BeginPhysicsStep()
+{
+	m_continuousBodies.clear();
+	uint numShapes = m_shapes.GetCount();
+	for( uint rowIdx = 0; rowIdx < numShapes; ++rowIdx )
+	{
+		m_shapeTables.m_prevVelocities[rowIdx] = m_shapes[rowIdx]->m_rigidbody->GetVelocity();
+		if( m_shapeTables.HasFlag( rowIdx, SHAPE_FLAG_CONTINUOUS ) )
+		{
+			ContinuousBody body;
+			body.m_row = rowIdx;
+			body.m_start = static_cast<const PillboxCollider2D*>( m_shapes[rowIdx]->m_collider )->GetWorldShape();
+			m_continuousBodies.push_back( body );
+		}
+	}
+
+	WakeSleepersInReach( g_theApp->m_physicsSteps->GetStepSeconds() );
+}
+
+//--------------------------------------------------------------------------
+/**
+* EndPhysicsStep
+* Turns the kinematic bodies, then sweeps every continuous collision body against
+* its neighbours over the step just taken. A movable body that touched something
+* partway through is held back at the touch instead of wherever the step left it,
+* possibly on the far side. Whatever a kinematic body still overlaps is pushed out,
+* and then the step's contacts are found and diffed against the last step's.
+*/
+void Map::EndPhysicsStep( float stepSeconds )
+{
+	SpinKinematicBodies( stepSeconds );
+
+	m_continuousHits.clear();
+	for( const ContinuousBody& body: m_continuousBodies )
+	{
+		const Shape* shape = m_shapes[body.m_row];
+		PillboxSweep sweep;
+		sweep.Set( body.m_start, static_cast<const PillboxCollider2D*>( shape->m_collider )->GetWorldShape() );
+
+		Vec2 startHalfSize = GetPillboxHalfSize( body.m_start );
+		Vec2 endHalfSize = GetPillboxHalfSize( sweep.m_end );
+		Vec2 startCenter = body.m_start.m_obb.m_center;
+		Vec2 endCenter = sweep.m_end.m_obb.m_center;
+		Vec2 margin = Vec2( CONTINUOUS_QUERY_MARGIN, CONTINUOUS_QUERY_MARGIN );
+		Vec2 mins = Vec2( std::min( startCenter.x - startHalfSize.x, endCenter.x - endHalfSize.x ), std::min( startCenter.y - startHalfSize.y, endCenter.y - endHalfSize.y ) ) - margin;
+		Vec2 maxs = Vec2( std::max( startCenter.x + startHalfSize.x, endCenter.x + endHalfSize.x ), std::max( startCenter.y + startHalfSize.y, endCenter.y + endHalfSize.y ) ) + margin;
+		m_continuousScratch.clear();
+		QueryAABB( mins, maxs, m_continuousScratch );
+
+		for( const Shape* other: m_continuousScratch )
+		{
+			uint otherRow = m_shapes.GetDenseIndex( other->m_handle );
+			bool isMovable = IsMovable( shape );
+			bool isOtherMovable = IsMovable( other );
+			if( other == shape || ( !isMovable && !isOtherMovable ) )
+			{
+				continue;
+			}
+
+			// Pairs of two continuous bodies are swept once, from the lower row
+			PillboxSweep otherSweep;
+			Pillbox2 otherEnd = static_cast<const PillboxCollider2D*>( other->m_collider )->GetWorldShape();
+			if( m_shapeTables.HasFlag( otherRow, SHAPE_FLAG_CONTINUOUS ) )
+			{
+				if( otherRow < body.m_row )
+				{
+					continue;
+				}
+				const ContinuousBody* otherBody = nullptr;
+				for( const ContinuousBody& candidate: m_continuousBodies )
+				{
+					otherBody = candidate.m_row == otherRow ? &candidate : otherBody;
+				}
+				otherSweep.Set( otherBody ? otherBody->m_start : otherEnd, otherEnd );
+			}
+			else
+			{
+				// Only moves in a straight line as far as anyone can tell
+				Pillbox2 otherStart = otherEnd;
+				otherStart.m_obb.m_center -= other->m_rigidbody->GetVelocity() * stepSeconds;
+				otherSweep.Set( otherStart, otherEnd );
+			}
+
+			// Resting contacts and slow pairs are left to the solver
+			float thickness = std::min( GetPillboxHalfThickness( sweep.m_end ), GetPillboxHalfThickness( otherEnd ) );
+			float time;
+			if( sweep.GetMotionBound() + otherSweep.GetMotionBound() < thickness
+				|| GetPillboxSeparation( sweep.m_end, sweep.GetPose( 0.0f ), otherEnd, otherSweep.GetPose( 0.0f ) ) <= CONTINUOUS_SLOP
+				|| !FindPillboxTimeOfImpact( sweep, otherSweep, CONTINUOUS_SLOP, time ) )
+			{
+				continue;
+			}
+			if( isMovable )
+			{
+				AddContinuousHit( body.m_row, sweep, otherRow, otherSweep, time, stepSeconds );
+			}
+			if( isOtherMovable )
+			{
+				AddContinuousHit( otherRow, otherSweep, body.m_row, sweep, time, stepSeconds );
+			}
+		}
+	}
+
+	for( const ContinuousHit& hit: m_continuousHits )
+	{
+		ApplyContinuousHit( hit );
+	}
+	m_numContinuousHits += (uint) m_continuousHits.size();
+
+	PushFromKinematicBodies( stepSeconds );
+
+	GatherShapeState();
+	FindContacts();
+	UpdateContactEvents();
+	++m_numEventSteps;
+
+	if( m_isDeterministic )
+	{
+		m_lastStepHash = GetPhysicsStateHash();
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* AddContinuousHit
+* Keeps only the body's earliest touch of the step.
+*/
+void Map::AddContinuousHit( uint rowIdx, const PillboxSweep& sweep, uint otherRow, const PillboxSweep& otherSweep, float time, float stepSeconds )
+{
+	ContinuousHit* hit = nullptr;
+	for( ContinuousHit& existing: m_continuousHits )
+	{
+		hit = existing.m_row == rowIdx ? &existing : hit;
+	}
+	if( hit && hit->m_time <= time )
+	{
+		return;
+	}
+	if( !hit )
+	{
+		m_continuousHits.emplace_back();
+		hit = &m_continuousHits.back();
+	}
+
+	PillboxPose pose = sweep.GetPose( time );
+	PillboxPose otherPose = otherSweep.GetPose( time );
+	hit->m_row = rowIdx;
+	hit->m_otherRow = otherRow;
+	hit->m_time = time;
+	hit->m_center = pose.m_center;
+	hit->m_normal = GetPillboxSeparationNormal( otherSweep.m_end, otherPose, sweep.m_end, pose );
+
+	// Near enough the touch for a surface velocity
+	float reach = std::min( GetPillboxBoundRadius( sweep.m_end ), ( pose.m_center - otherPose.m_center ).GetLength() );
+	hit->m_otherVelocity = otherSweep.GetPointVelocity( pose.m_center - hit->m_normal * reach, stepSeconds );
+	hit->m_otherEnd = otherSweep.m_end;
+}
+
+//--------------------------------------------------------------------------
+/**
+* ApplyContinuousHit
+* Puts the body back where it touched, pushed clear of wherever the other body
+* ended up, and takes away its velocity into the other body.
+*/
+void Map::ApplyContinuousHit( const ContinuousHit& hit )
+{
+	Shape* shape = m_shapes[hit.m_row];
+	Pillbox2 end = static_cast<const PillboxCollider2D*>( shape->m_collider )->GetWorldShape();
+	PillboxPose pose = { hit.m_center, end.m_obb.GetRight() };
+	PillboxPose otherPose = { hit.m_otherEnd.m_obb.m_center, hit.m_otherEnd.m_obb.GetRight() };
+	for( int pushIdx = 0; pushIdx < CONTINUOUS_MAX_PUSHES; ++pushIdx )
+	{
+		float separation = GetPillboxSeparation( hit.m_otherEnd, otherPose, end, pose );
+		if( separation >= 0.0f )
+		{
+			break;
+		}
+		pose.m_center += hit.m_normal * ( CONTINUOUS_SLOP - separation );
+	}
+	shape->SetPosition( shape->GetPosition() + pose.m_center - end.m_obb.m_center );
+
+	Vec2 velocity = shape->m_rigidbody->GetVelocity();
+	float approach = DotProduct( velocity - hit.m_otherVelocity, hit.m_normal );
+	if( approach < 0.0f )
+	{
+		shape->m_rigidbody->SetVelocity( velocity - hit.m_normal * approach );
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* SpinKinematicBodies
+* Physics holds kinematic bodies still, so the map sets their rotation at the end
+* of each step from their angular velocity. A changed rate, or a rotation set by
+* the editor or a respawn, starts the spin over from where the body is.
+*/
+void Map::SpinKinematicBodies( float stepSeconds )
+{
+	double endSeconds = m_physicsSeconds + (double) stepSeconds;
+	m_kinematicBodies.clear();
+	uint numShapes = m_shapes.GetCount();
+	for( uint rowIdx = 0; rowIdx < numShapes; ++rowIdx )
+	{
+		if( !m_shapeTables.HasFlag( rowIdx, SHAPE_FLAG_KINEMATIC ) )
+		{
+			continue;
+		}
+		Shape* shape = m_shapes[rowIdx];
+		ContinuousBody body;
+		body.m_row = rowIdx;
+		body.m_start = static_cast<const PillboxCollider2D*>( shape->m_collider )->GetWorldShape();
+		m_kinematicBodies.push_back( body );
+
+		KinematicSpin& spin = m_shapeTables.m_kinematicSpins[rowIdx];
+		float rate = shape->m_rigidbody->GetAngularVelocity();
+		float rotation = shape->m_transform.m_rotation;
+		if( rate != spin.m_rate || rotation != spin.m_lastRotation )
+		{
+			spin.m_baseTime = m_physicsSeconds;
+			spin.m_baseRotation = rotation;
+			spin.m_rate = rate;
+		}
+		spin.m_lastRotation = (float) ( (double) spin.m_baseRotation + (double) spin.m_rate * ( endSeconds - spin.m_baseTime ) );
+		shape->m_transform.m_rotation = spin.m_lastRotation;
+	}
+	m_physicsSeconds = endSeconds;
+}
+
+//--------------------------------------------------------------------------
+/**
+* PushFromKinematicBodies
+* Kinematic bodies move as if of infinite mass: a dynamic body left overlapping one
+* is moved clear and bounced off the surface's velocity, and nothing pushes back.
+* Sleeping bodies are woken first.
+*/
+void Map::PushFromKinematicBodies( float stepSeconds )
+{
+	for( const ContinuousBody& body: m_kinematicBodies )
+	{
+		const Shape* shape = m_shapes[body.m_row];
+		PillboxSweep sweep;
+		sweep.Set( body.m_start, static_cast<const PillboxCollider2D*>( shape->m_collider )->GetWorldShape() );
+		PillboxPose pose = sweep.GetPose( 1.0f );
+
+		Vec2 halfSize = GetPillboxHalfSize( sweep.m_end ) + Vec2( CONTINUOUS_SLOP, CONTINUOUS_SLOP );
+		m_continuousScratch.clear();
+		QueryAABB( pose.m_center - halfSize, pose.m_center + halfSize, m_continuousScratch );
+
+		for( Shape* other: m_continuousScratch )
+		{
+			if( other->m_definition.m_bodyType != SHAPE_BODY_DYNAMIC
+				|| ( other->m_rigidbody->IsXRestricted() && other->m_rigidbody->IsYRestricted() ) )
+			{
+				continue;
+			}
+			Pillbox2 otherEnd = static_cast<const PillboxCollider2D*>( other->m_collider )->GetWorldShape();
+			PillboxPose otherPose = { otherEnd.m_obb.m_center, otherEnd.m_obb.GetRight() };
+			float separation = GetPillboxSeparation( sweep.m_end, pose, otherEnd, otherPose );
+			if( separation > CONTINUOUS_SLOP )
+			{
+				continue;
+			}
+
+			WakeShape( other->m_handle );
+			Vec2 normal = GetPillboxSeparationNormal( sweep.m_end, pose, otherEnd, otherPose );
+			float reach = std::min( GetPillboxBoundRadius( otherEnd ), ( otherPose.m_center - pose.m_center ).GetLength() );
+			Vec2 surfaceVelocity = sweep.GetPointVelocity( otherPose.m_center - normal * reach, stepSeconds );
+
+			Vec2 startCenter = otherPose.m_center;
+			for( int pushIdx = 0; pushIdx < CONTINUOUS_MAX_PUSHES && separation < 0.0f; ++pushIdx )
+			{
+				otherPose.m_center += normal * ( CONTINUOUS_SLOP - separation );
+				separation = GetPillboxSeparation( sweep.m_end, pose, otherEnd, otherPose );
+			}
+			other->SetPosition( other->GetPosition() + otherPose.m_center - startCenter );
+
+			Vec2 velocity = other->m_rigidbody->GetVelocity();
+			float approach = DotProduct( velocity - surfaceVelocity, normal );
+			if( approach < 0.0f )
+			{
+				other->m_rigidbody->SetVelocity( velocity - normal * ( approach * ( 1.0f + other->m_definition.m_restitution ) ) );
+				++m_numKinematicPushes;
+			}
+		}
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* WriteShapeState
+*/
+void Map::WriteShapeState( uint denseIdx )
+{
+	const Shape* shape = m_shapes[denseIdx];
+	if( m_shapeTables.HasFlag( denseIdx, SHAPE_FLAG_ASLEEP ) && shape->m_rigidbody->GetSimulationType() == PHYSICS_SIM_DYNAMIC )
+	{
+		// Woken some other way, by the editor
+		SetAsleep( denseIdx, false );
+	}
+	m_shapeTables.m_worldShapes[denseIdx]	= static_cast<const PillboxCollider2D*>( shape->m_collider )->GetWorldShape();
+	m_shapeTables.m_fillColors[denseIdx]	= shape->GetFillColor();
+	m_shapeTables.m_borderColors[denseIdx]	= shape->DeterminColor( m_shapeTables.HasFlag( denseIdx, SHAPE_FLAG_TOUCHING ) );
+	m_shapeTables.SetFlag( denseIdx, SHAPE_FLAG_DYNAMIC, shape->m_rigidbody->GetSimulationType() == PHYSICS_SIM_DYNAMIC );
+	m_shapeTables.SetFlag( denseIdx, SHAPE_FLAG_CONTINUOUS, shape->m_definition.m_continuous );
+	m_shapeTables.SetFlag( denseIdx, SHAPE_FLAG_KINEMATIC, shape->m_definition.m_bodyType == SHAPE_BODY_KINEMATIC );
+	m_shapeTables.SetActive( denseIdx, shape->m_definition.m_bodyType != SHAPE_BODY_STATIC && !m_shapeTables.HasFlag( denseIdx, SHAPE_FLAG_ASLEEP ) );
+
+	m_maxShapeBoundRadius = std::max( m_maxShapeBoundRadius, GetPillboxBoundRadius( m_shapeTables.m_worldShapes[denseIdx] ) );
+}
+
+//--------------------------------------------------------------------------
+/**
+* UpdateShapeCell
+* Refiles the shape in the grid if its center has left its cell.
+*/
+void Map::UpdateShapeCell( uint denseIdx )
+{
+	uint64_t cellKey = m_shapeGrid.GetCellKey( m_shapeTables.m_worldShapes[denseIdx].m_obb.m_center );
+	m_shapeGrid.Move( m_shapes[denseIdx]->m_handle, m_shapeTables.m_gridCells[denseIdx], cellKey );
+	m_shapeTables.m_gridCells[denseIdx] = cellKey;
+}
+
+//--------------------------------------------------------------------------
+/**
+* FindContacts
+* Runs the broadphase over the gathered shapes, then tests every candidate pair
+* in one batch and keeps the pairs whose pillboxes actually overlap.
+*/
+void Map::FindContacts()
+{
+	m_broadphase.Update( m_shapes, m_shapeTables );
+	const std::vector<ShapePair>& candidates = m_broadphase.GetCandidates();
+	m_contactBatch.Clear();
+	m_contactBatch.Reserve( (uint) candidates.size() );
+	for( const ShapePair& pair: candidates )
+	{
+		m_contactBatch.Add( m_shapeTables.m_worldShapes[pair.m_rowA], m_shapeTables.m_worldShapes[pair.m_rowB] );
+	}
+	m_contactSeparations.resize( candidates.size() );
+
+	// The SIMD lanes and the scalar tail round differently, so a pair's result
+	// would depend on where it landed in the batch
+	m_contactBatch.ComputeSeparations( m_contactSeparations.data(), !m_isDeterministic );
+
+	m_contacts.clear();
+	m_areContactsStale = false;
+	for( uint pairIdx = 0; pairIdx < (uint) candidates.size(); ++pairIdx )
+	{
+		if( m_contactSeparations[pairIdx] <= 0.0f )
+		{
+			m_contacts.push_back( candidates[pairIdx] );
+		}
+	}
+
+	// Candidates come out in sweep order, which depends on how earlier frames sorted
+	if( m_isDeterministic )
+	{
+		for( ShapePair& pair: m_contacts )
+		{
+			if( pair.m_rowB < pair.m_rowA )
+			{
+				std::swap( pair.m_a, pair.m_b );
+				std::swap( pair.m_rowA, pair.m_rowB );
+			}
+		}
+		std::sort( m_contacts.begin(), m_contacts.end(), []( const ShapePair& lhs, const ShapePair& rhs )
+		{
+			return lhs.m_rowA != rhs.m_rowA ? lhs.m_rowA < rhs.m_rowA : lhs.m_rowB < rhs.m_rowB;
+		} );
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* UpdateContactEvents
+* Walks this step's contacts and the last step's together in slot order, the way
+* trigger contacts are diffed, and appends what began, persisted and ended.
+*/
+void Map::UpdateContactEvents()
+{
+	m_contactRecords.clear();
+	for( const ShapePair& pair: m_contacts )
+	{
+		bool isSwapped = pair.m_b.m_slot < pair.m_a.m_slot;
+		ContactRecord record;
+		record.m_a = isSwapped ? pair.m_b : pair.m_a;
+		record.m_b = isSwapped ? pair.m_a : pair.m_b;
+		record.m_key = ( (uint64_t) record.m_a.m_slot << 32 ) | record.m_b.m_slot;
+		m_contactRecords.push_back( record );
+	}
+	std::sort( m_contactRecords.begin(), m_contactRecords.end(), []( const ContactRecord& lhs, const ContactRecord& rhs )
+	{
+		return lhs.m_key < rhs.m_key;
+	} );
+
+	uint numPrev = (uint) m_prevContactRecords.size();
+	uint numCur = (uint) m_contactRecords.size();
+	uint prevIdx = 0;
+	uint curIdx = 0;
+	while( prevIdx < numPrev || curIdx < numCur )
+	{
+		const ContactRecord* prev = prevIdx < numPrev ? &m_prevContactRecords[prevIdx] : nullptr;
+		const ContactRecord* cur = curIdx < numCur ? &m_contactRecords[curIdx] : nullptr;
+		if( cur && ( !prev || cur->m_key < prev->m_key ) )
+		{
+			AddContactEvent( *cur, CONTACT_BEGIN );
+			++curIdx;
+		}
+		else if( !cur || prev->m_key < cur->m_key )
+		{
+			AddContactEvent( *prev, CONTACT_END );
+			++prevIdx;
+		}
+		else
+		{
+			// A reused slot holds a different shape
+			if( prev->m_a == cur->m_a && prev->m_b == cur->m_b )
+			{
+				AddContactEvent( *cur, CONTACT_PERSIST );
+			}
+			else
+			{
+				AddContactEvent( *prev, CONTACT_END );
+				AddContactEvent( *cur, CONTACT_BEGIN );
+			}
+			++prevIdx;
+			++curIdx;
+		}
+	}
+	std::swap( m_contactRecords, m_prevContactRecords );
+}
+
+//--------------------------------------------------------------------------
+/**
+* AddContactEvent
+* The impulse is what it took to change the pair's approach speed over the step,
+* with static and sleeping bodies taken as immovable.
+*/
+void Map::AddContactEvent( const ContactRecord& record, eContactEventType type )
+{
+	ContactEvent event;
+	event.m_a = record.m_a;
+	event.m_b = record.m_b;
+	event.m_type = type;
+	event.m_step = m_numEventSteps;
+	if( type != CONTACT_END )
+	{
+		uint rowA = m_shapes.GetDenseIndex( record.m_a );
+		uint rowB = m_shapes.GetDenseIndex( record.m_b );
+		const Pillbox2& worldA = m_shapeTables.m_worldShapes[rowA];
+		const Pillbox2& worldB = m_shapeTables.m_worldShapes[rowB];
+		PillboxPose poseA = { worldA.m_obb.m_center, worldA.m_obb.GetRight() };
+		PillboxPose poseB = { worldB.m_obb.m_center, worldB.m_obb.GetRight() };
+		event.m_normal = GetPillboxSeparationNormal( worldA, poseA, worldB, poseB );
+
+		const Shape* shapeA = m_shapes[rowA];
+		const Shape* shapeB = m_shapes[rowB];
+		float inverseMassA = m_shapeTables.HasFlag( rowA, SHAPE_FLAG_DYNAMIC ) && shapeA->m_definition.m_mass > 0.0f ? 1.0f / shapeA->m_definition.m_mass : 0.0f;
+		float inverseMassB = m_shapeTables.HasFlag( rowB, SHAPE_FLAG_DYNAMIC ) && shapeB->m_definition.m_mass > 0.0f ? 1.0f / shapeB->m_definition.m_mass : 0.0f;
+		if( inverseMassA + inverseMassB > 0.0f )
+		{
+			Vec2 relativeVelocity = shapeB->m_rigidbody->GetVelocity() - shapeA->m_rigidbody->GetVelocity();
+			Vec2 prevRelativeVelocity = m_shapeTables.m_prevVelocities[rowB] - m_shapeTables.m_prevVelocities[rowA];
+			float speedChange = DotProduct( relativeVelocity - prevRelativeVelocity, event.m_normal );
+			event.m_impulse = std::max( speedChange, 0.0f ) / ( inverseMassA + inverseMassB );
+		}
+	}
+	m_contactEvents.push_back( event );
+}
+
+//--------------------------------------------------------------------------
+/**
+* ProcessContactEvents
+* One pass over the frame's events, step by step, for everything gameplay does with
+* contacts: border tints follow begin and end, and the player takes collision damage
+* for each physics step where it touched anything, scaled by the step length, so
+* neither the frame rate nor the step rate changes how fast it goes.
+*/
+void Map::ProcessContactEvents()
+{
+	uint numHitSteps = 0;
+	uint lastHitStep = 0;
+	for( const ContactEvent& event: m_contactEvents )
+	{
+		if( event.m_type != CONTACT_PERSIST )
+		{
+			int delta = event.m_type == CONTACT_BEGIN ? 1 : -1;
+			AddTouching( event.m_a, delta );
+			AddTouching( event.m_b, delta );
+		}
+		if( event.m_type != CONTACT_END && ( event.m_a == m_player || event.m_b == m_player )
+			&& ( numHitSteps == 0 || event.m_step != lastHitStep ) )
+		{
+			++numHitSteps;
+			lastHitStep = event.m_step;
+		}
+	}
+
+	Shape* player = GetPlayer();
+	if( numHitSteps > 0 && player && player->IsAlive() )
+	{
+		g_theApp->m_gameTimers->Reset( player->m_preventInputTimer );
+		DamagePlayer( player->GetCollisionDamage() * (float) numHitSteps * g_theApp->m_physicsSteps->GetStepSeconds() );
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* AddTouching
+* Counts a contact beginning or ending for a shape and retints it when it starts
+* or stops touching anything. Ignores stale handles.
+*/
+void Map::AddTouching( ShapeHandle handle, int delta )
+{
+	uint rowIdx = m_shapes.GetDenseIndex( handle );
+	if( rowIdx >= m_shapeTables.GetCount() )
+	{
+		return;
+	}
+	uint16_t& numContacts = m_shapeTables.m_numContacts[rowIdx];
+	numContacts = (uint16_t) std::max( (int) numContacts + delta, 0 );
+	bool isTouching = numContacts > 0;
+	if( isTouching != m_shapeTables.HasFlag( rowIdx, SHAPE_FLAG_TOUCHING ) )
+	{
+		m_shapeTables.SetFlag( rowIdx, SHAPE_FLAG_TOUCHING, isTouching );
+		m_shapeTables.m_borderColors[rowIdx] = m_shapes[rowIdx]->DeterminColor( isTouching );
+	}
+}
+
+//--------------------------------------------------------------------------
+// Helper
+static uint64_t HashStateBytes( uint64_t hash, const void* data, size_t size )
+{
+	const uint8_t* bytes = (const uint8_t*) data;
+	for( size_t byteIdx = 0; byteIdx < size; ++byteIdx )
+	{
+		hash = ( hash ^ bytes[byteIdx] ) * STATE_HASH_PRIME;
+	}
+	return hash;
+}
+
+//--------------------------------------------------------------------------
+/**
+* GetPhysicsStateHash
+* 64-bit FNV-1a over the exact bits of every rigidbody's transform, velocities and
+* simulation type. Shapes from the map file go in file order, then spawned shapes
+* in the order they sit in the slot map, so two runs of a level hash alike however
+* their regions streamed in.
+*/
+uint64_t Map::GetPhysicsStateHash() const
+{
+	uint numShapes = m_shapes.GetCount();
+	m_hashOrder.resize( numShapes );
+	for( uint rowIdx = 0; rowIdx < numShapes; ++rowIdx )
+	{
+		m_hashOrder[rowIdx] = rowIdx;
+	}
+	std::stable_sort( m_hashOrder.begin(), m_hashOrder.end(), [this]( uint lhs, uint rhs )
+	{
+		uint lhsKey = (uint) m_shapes[lhs]->m_pristineIdx;	// -1 sorts last
+		uint rhsKey = (uint) m_shapes[rhs]->m_pristineIdx;
+		return lhsKey < rhsKey;
+	} );
+
+	uint64_t hash = STATE_HASH_OFFSET;
+	for( uint rowIdx: m_hashOrder )
+	{
+		const Shape* shape = m_shapes[rowIdx];
+		const Rigidbody2D* rigidbody = shape->m_rigidbody;
+		float state[6];
+		state[0] = shape->m_transform.m_position.x;
+		state[1] = shape->m_transform.m_position.y;
+		state[2] = shape->m_transform.m_rotation;
+		state[3] = rigidbody->GetVelocity().x;
+		state[4] = rigidbody->GetVelocity().y;
+		state[5] = rigidbody->GetAngularVelocity();
+		int32_t simType = (int32_t) rigidbody->GetSimulationType();
+		hash = HashStateBytes( hash, state, sizeof( state ) );
+		hash = HashStateBytes( hash, &simType, sizeof( simType ) );
+	}
+	return hash;
+}
+
+//--------------------------------------------------------------------------
+// Helper
+static uint FindIslandRoot( std::vector<uint>& parents, uint nodeIdx )
+{
+	while( parents[nodeIdx] != nodeIdx )
+	{
+		parents[nodeIdx] = parents[parents[nodeIdx]];
+		nodeIdx = parents[nodeIdx];
+	}
+	return nodeIdx;
+}
+
+//--------------------------------------------------------------------------
+/**
+* UpdateSleeping
+* Dynamic bodies whose bounds overlap form islands. An island where every body
+* has rested for SLEEP_DELAY goes to sleep together, and wakes together once any
+* body in it moves. Anything coming from outside the island is caught by
+* WakeSleepersInReach before the step that would reach it.
+* Only active rows, and the sleepers the broadphase pairs them with, are visited.
+*/
+void Map::UpdateSleeping( float physicsSeconds )
+{
+	m_islandNodes.resize( m_shapes.GetCount(), NO_ISLAND_NODE );
+	m_islandRows.clear();
+	m_islandParents.clear();
+	m_islandFlags.clear();
+	for( uint rowIdx: m_shapeTables.m_activeRows )
+	{
+		if( m_shapes[rowIdx]->m_definition.m_bodyType != SHAPE_BODY_DYNAMIC
+			|| m_shapeTables.HasFlag( rowIdx, SHAPE_FLAG_SELECTED ) || m_shapeTables.HasFlag( rowIdx, SHAPE_FLAG_GARBAGE ) )
+		{
+			m_shapeTables.m_restSeconds[rowIdx] = 0.0f;
+			continue;
+		}
+
+		uint8_t flags = ISLAND_MEMBER;
+		const Rigidbody2D* rigidbody = m_shapes[rowIdx]->m_rigidbody;
+		if( rigidbody->GetVelocity().GetLengthSquared() < SLEEP_SPEED * SLEEP_SPEED && fabsf( rigidbody->GetAngularVelocity() ) < SLEEP_ANGULAR_SPEED )
+		{
+			m_shapeTables.m_restSeconds[rowIdx] += physicsSeconds;
+		}
+		else
+		{
+			m_shapeTables.m_restSeconds[rowIdx] = 0.0f;
+			flags |= ISLAND_MOVING;
+		}
+		if( m_shapeTables.m_restSeconds[rowIdx] < SLEEP_DELAY )
+		{
+			flags |= ISLAND_RESTLESS;
+		}
+		AddIslandNode( rowIdx, flags );
+	}
+
+	// Static level geometry doesn't join islands, or everything would touch everything
+	for( const ShapePair& pair: m_broadphase.GetCandidates() )
+	{
+		uint nodeA = FindIslandNode( pair.m_rowA );
+		uint nodeB = FindIslandNode( pair.m_rowB );
+		if( nodeA != NO_ISLAND_NODE && nodeB != NO_ISLAND_NODE )
+		{
+			m_islandParents[FindIslandRoot( m_islandParents, nodeA )] = FindIslandRoot( m_islandParents, nodeB );
+		}
+	}
+	uint numNodes = (uint) m_islandRows.size();
+	for( uint nodeIdx = 0; nodeIdx < numNodes; ++nodeIdx )
+	{
+		m_islandFlags[FindIslandRoot( m_islandParents, nodeIdx )] |= m_islandFlags[nodeIdx];
+	}
+
+	for( uint nodeIdx = 0; nodeIdx < numNodes; ++nodeIdx )
+	{
+		uint rowIdx = m_islandRows[nodeIdx];
+		uint8_t islandFlags = m_islandFlags[FindIslandRoot( m_islandParents, nodeIdx )];
+		bool isAsleep = m_shapeTables.HasFlag( rowIdx, SHAPE_FLAG_ASLEEP );
+		if( isAsleep && ( islandFlags & ISLAND_MOVING ) )
+		{
+			SetAsleep( rowIdx, false );
+		}
+		else if( !isAsleep && !( islandFlags & ISLAND_RESTLESS ) )
+		{
+			SetAsleep( rowIdx, true );
+		}
+		m_islandNodes[rowIdx] = NO_ISLAND_NODE;
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* AddIslandNode
+*/
+uint Map::AddIslandNode( uint rowIdx, uint8_t flags )
+{
+	uint nodeIdx = (uint) m_islandRows.size();
+	m_islandNodes[rowIdx] = nodeIdx;
+	m_islandRows.push_back( rowIdx );
+	m_islandParents.push_back( nodeIdx );
+	m_islandFlags.push_back( flags );
+	return nodeIdx;
+}
+
+//--------------------------------------------------------------------------
+/**
+* FindIslandNode
+* The row's node, if it joins an island. Sleepers aren't active, so each gets
+* its node the first time a pair reaches it.
+*/
+uint Map::FindIslandNode( uint rowIdx )
+{
+	if( m_islandNodes[rowIdx] != NO_ISLAND_NODE )
+	{
+		return m_islandNodes[rowIdx];
+	}
+	if( m_shapeTables.HasFlag( rowIdx, SHAPE_FLAG_ASLEEP )
+		&& !m_shapeTables.HasFlag( rowIdx, SHAPE_FLAG_SELECTED ) && !m_shapeTables.HasFlag( rowIdx, SHAPE_FLAG_GARBAGE ) )
+	{
+		return AddIslandNode( rowIdx, ISLAND_MEMBER );
+	}
+	return NO_ISLAND_NODE;
+}
+
+//--------------------------------------------------------------------------
+/**
+* SetAsleep
+* Sleeping bodies are switched to static, so physics neither moves them nor tests
+* them against other static bodies.
+*/
+void Map::SetAsleep( uint rowIdx, bool isAsleep )
+{
+	Rigidbody2D* rigidbody = m_shapes[rowIdx]->m_rigidbody;
+	if( isAsleep )
+	{
+		rigidbody->SetVelocity( Vec2::ZERO );
+		rigidbody->SetSimulationType( PHYSICS_SIM_STATIC );
+	}
+	else
+	{
+		rigidbody->ResetSimulationType();
+		m_shapeTables.m_restSeconds[rowIdx] = 0.0f;
+	}
+	if( m_shapeTables.HasFlag( rowIdx, SHAPE_FLAG_ASLEEP ) != isAsleep )
+	{
+		m_numAsleep = isAsleep ? m_numAsleep + 1 : m_numAsleep - 1;
+	}
+	m_shapeTables.SetFlag( rowIdx, SHAPE_FLAG_ASLEEP, isAsleep );
+	m_shapeTables.SetFlag( rowIdx, SHAPE_FLAG_DYNAMIC, !isAsleep );
+	m_shapeTables.SetActive( rowIdx, !isAsleep );
+}
+
+//--------------------------------------------------------------------------
+/**
+* WakeSleepersInReach
+* Sleepers are static to physics, so a body arriving at one would stop dead as if
+* it hit a wall. Before each step, every sleeper within reach of a moving or
+* kinematic body over the step is woken, along with the sleepers resting against it.
+*/
+void Map::WakeSleepersInReach( float stepSeconds )
+{
+	if( m_numAsleep == 0 )
+	{
+		return;
+	}
+
+	// Waking appends to m_activeRows; the newly woken are at rest and needn't be visited
+	m_wakeRows.clear();
+	uint numActive = (uint) m_shapeTables.m_activeRows.size();
+	for( uint activeIdx = 0; activeIdx < numActive; ++activeIdx )
+	{
+		uint rowIdx = m_shapeTables.m_activeRows[activeIdx];
+		const Rigidbody2D* rigidbody = m_shapes[rowIdx]->m_rigidbody;
+		Vec2 velocity = rigidbody->GetVelocity();
+		bool isMoving = m_shapeTables.HasFlag( rowIdx, SHAPE_FLAG_DYNAMIC )
+			&& ( velocity.GetLengthSquared() >= SLEEP_SPEED * SLEEP_SPEED || fabsf( rigidbody->GetAngularVelocity() ) >= SLEEP_ANGULAR_SPEED );
+		if( !isMoving && !m_shapeTables.HasFlag( rowIdx, SHAPE_FLAG_KINEMATIC ) )
+		{
+			continue;
+		}
+
+		// Bound radius, so turning during the step is covered too
+		const Pillbox2& pill = m_shapeTables.m_worldShapes[rowIdx];
+		float radius = GetPillboxBoundRadius( pill );
+		Vec2 start = pill.m_obb.m_center;
+		Vec2 end = start + velocity * stepSeconds;
+		WakeSleepersOverlapping( Vec2( std::min( start.x, end.x ) - radius, std::min( start.y, end.y ) - radius )
+			, Vec2( std::max( start.x, end.x ) + radius, std::max( start.y, end.y ) + radius ) );
+	}
+
+	// Islands go down together, so they come back up together
+	while( !m_wakeRows.empty() )
+	{
+		uint rowIdx = m_wakeRows.back();
+		m_wakeRows.pop_back();
+		const Pillbox2& pill = m_shapeTables.m_worldShapes[rowIdx];
+		Vec2 halfSize = GetPillboxHalfSize( pill );
+		WakeSleepersOverlapping( pill.m_obb.m_center - halfSize, pill.m_obb.m_center + halfSize );
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* WakeSleepersOverlapping
+* Queues each sleeper it wakes on m_wakeRows.
+*/
+void Map::WakeSleepersOverlapping( const Vec2& mins, const Vec2& maxs )
+{
+	m_wakeScratch.clear();
+	QueryAABB( mins, maxs, m_wakeScratch );
+	for( const Shape* other: m_wakeScratch )
+	{
+		uint otherRow = m_shapes.GetDenseIndex( other->m_handle );
+		if( m_shapeTables.HasFlag( otherRow, SHAPE_FLAG_ASLEEP ) )
+		{
+			SetAsleep( otherRow, false );
+			m_wakeRows.push_back( otherRow );
+		}
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* WakeShape
+*/
+void Map::WakeShape( ShapeHandle handle )
+{
+	uint denseIdx = m_shapes.GetDenseIndex( handle );
+	if( denseIdx < m_shapeTables.GetCount() && m_shapeTables.HasFlag( denseIdx, SHAPE_FLAG_ASLEEP ) )
+	{
+		SetAsleep( denseIdx, false );
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* QueryNearest
+* Shape whose center is closest to the point, nullptr if none is within maxDistance.
+*/
+Shape* Map::QueryNearest( const Vec2& point, float maxDistance ) const
+{
+	Shape* nearest = nullptr;
+	float nearestDistSq = maxDistance * maxDistance;
+	float cellSize = m_shapeGrid.GetCellSize();
+	int maxRing = m_shapeGrid.GetMaxRing( point );
+	for( int ring = 0; ring <= maxRing; ++ring )
+	{
+		// The point can sit on the edge of its own cell
+		float ringDistance = (float) ( ring - 1 ) * cellSize;
+		if( ring > 1 && ringDistance * ringDistance > nearestDistSq )
+		{
+			break;
+		}
+
+		m_queryScratch.clear();
+		m_shapeGrid.GatherRing( point, ring, m_queryScratch );
+		for( ShapeHandle handle: m_queryScratch )
+		{
+			uint denseIdx = m_shapes.GetDenseIndex( handle );
+			float distSq = ( m_shapeTables.m_worldShapes[denseIdx].m_obb.m_center - point ).GetLengthSquared();
+			if( distSq < nearestDistSq )
+			{
+				nearestDistSq = distSq;
+				nearest = m_shapes[denseIdx];
+			}
+		}
+	}
+	return nearest;
+}
+
+//--------------------------------------------------------------------------
+/**
+* QueryPoint
+* Topmost shape containing the point.
+*/
+Shape* Map::QueryPoint( const Vec2& point ) const
+{
+	Vec2 reach = Vec2( m_maxShapeBoundRadius, m_maxShapeBoundRadius );
+	m_queryScratch.clear();
+	m_shapeGrid.GatherBox( point - reach, point + reach, m_queryScratch );
+
+	// Later rows draw on top
+	uint topIdx = m_shapes.GetCount();
+	for( ShapeHandle handle: m_queryScratch )
+	{
+		uint denseIdx = m_shapes.GetDenseIndex( handle );
+		if( ( topIdx == m_shapes.GetCount() || denseIdx > topIdx ) && GetDistanceToPillbox( m_shapeTables.m_worldShapes[denseIdx], point ) <= 0.0f )
+		{
+			topIdx = denseIdx;
+		}
+	}
+	return topIdx < m_shapes.GetCount() ? m_shapes[topIdx] : nullptr;
+}
+
+//--------------------------------------------------------------------------
+/**
+* QueryRadius
+* Appends every shape that touches the disc.
+*/
+void Map::QueryRadius( const Vec2& center, float radius, std::vector<Shape*>& out ) const
+{
+	Vec2 reach = Vec2( radius + m_maxShapeBoundRadius, radius + m_maxShapeBoundRadius );
+	m_queryScratch.clear();
+	m_shapeGrid.GatherBox( center - reach, center + reach, m_queryScratch );
+	for( ShapeHandle handle: m_queryScratch )
+	{
+		uint denseIdx = m_shapes.GetDenseIndex( handle );
+		if( GetDistanceToPillbox( m_shapeTables.m_worldShapes[denseIdx], center ) <= radius )
+		{
+			out.push_back( m_shapes[denseIdx] );
+		}
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* QueryAABB
+* Appends every shape whose bounds overlap the box.
+*/
+void Map::QueryAABB( const Vec2& mins, const Vec2& maxs, std::vector<Shape*>& out ) const
+{
+	Vec2 reach = Vec2( m_maxShapeBoundRadius, m_maxShapeBoundRadius );
+	m_queryScratch.clear();
+	m_shapeGrid.GatherBox( mins - reach, maxs + reach, m_queryScratch );
+	for( ShapeHandle handle: m_queryScratch )
+	{
+		uint denseIdx = m_shapes.GetDenseIndex( handle );
+		const Pillbox2& pill = m_shapeTables.m_worldShapes[denseIdx];
+		Vec2 halfSize = GetPillboxHalfSize( pill );
+		if( pill.m_obb.m_center.x + halfSize.x >= mins.x && pill.m_obb.m_center.x - halfSize.x <= maxs.x
+			&& pill.m_obb.m_center.y + halfSize.y >= mins.y && pill.m_obb.m_center.y - halfSize.y <= maxs.y )
+		{
+			out.push_back( m_shapes[denseIdx] );
+		}
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* GetDistanceToShape
+* Negative inside the shape.
+*/
+float Map::GetDistanceToShape( ShapeHandle handle, const Vec2& point ) const
+{
+	uint denseIdx = m_shapes.GetDenseIndex( handle );
+	if( denseIdx >= m_shapeTables.GetCount() )
+	{
+		return 999999999.0f;
+	}
+	return GetDistanceToPillbox( m_shapeTables.m_worldShapes[denseIdx], point );
+}
+
+//--------------------------------------------------------------------------
+/**
+* HasShapeFlag
+*/
+bool Map::HasShapeFlag( ShapeHandle handle, eShapeFlag flag ) const
+{
+	uint denseIdx = m_shapes.GetDenseIndex( handle );
+	return denseIdx < m_shapeTables.GetCount() && m_shapeTables.HasFlag( denseIdx, flag );
+}
+
+//--------------------------------------------------------------------------
+/**
+* SetShapeFlag
+*/
+void Map::SetShapeFlag( ShapeHandle handle, eShapeFlag flag, bool isSet )
+{
+	uint denseIdx = m_shapes.GetDenseIndex( handle );
+	if( denseIdx < m_shapeTables.GetCount() )
+	{
+		m_shapeTables.SetFlag( denseIdx, flag, isSet );
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* DeleteAllShapes
+*/
+void Map::DeleteAllShapes()
+{
+	m_hasLoaded = false;
+	m_shapes.Clear();
+	m_shapeTables.Clear();
+	m_shapeGrid.Clear();
+	m_broadphase.Clear();
+	m_contacts.clear();
+	m_contactEvents.clear();
+	m_prevContactRecords.clear();
+	m_numEventSteps = 0;
+	m_continuousBodies.clear();
+	m_kinematicBodies.clear();
+	m_numAsleep = 0;
+	m_maxShapeBoundRadius = 0.0f;
+	m_destroyQueue.clear();
+	m_pillPool.DestroyAll();
+	m_player = ShapeHandle::INVALID;
+	m_streamShapes.clear();
+	m_regionLoaded.clear();
+}
+
+//--------------------------------------------------------------------------
+/**
+* AddShape
+* The shape must come from m_pillPool.
+*/
+ShapeHandle Map::AddShape( Shape* shape )
+{
+	ASSERT_OR_DIE( m_pillPool.Owns( shape ), "Map shapes must be created from the map's pill pool" );
+	shape->m_handle = m_shapes.Add( shape );
+	shape->m_map = this;
+	uint rowIdx = m_shapeTables.Add();
+	WriteShapeState( rowIdx );
+	UpdateShapeCell( rowIdx );
+	m_shapeTables.SnapPreviousState( rowIdx );
+	return shape->m_handle;
+}
+
+//--------------------------------------------------------------------------
+/**
+* AddShapes
+* Spawns a batch in one go: storage is reserved once, every pill and body is
+* built in one pass, then the batch is registered with the slot map, tables
+* and grid together. Appends the new shapes to outShapes in definition order.
+*/
+void Map::AddShapes( const ShapeDefinition* definitions, uint count, std::vector<Shape*>& outShapes )
+{
+	uint firstRow = m_shapes.GetCount();
+	uint firstOut = (uint) outShapes.size();
+	m_pillPool.Reserve( count );
+	m_shapes.Reserve( firstRow + count );
+	m_shapeTables.Reserve( firstRow + count );
+	outShapes.reserve( firstOut + count );
+
+	for( uint defIdx = 0; defIdx < count; ++defIdx )
+	{
+		outShapes.push_back( m_pillPool.Create( definitions[defIdx] ) );
+	}
+
+	m_batchHandles.clear();
+	m_batchCells.clear();
+	for( uint defIdx = 0; defIdx < count; ++defIdx )
+	{
+		Shape* shape = outShapes[firstOut + defIdx];
+		shape->m_handle = m_shapes.Add( shape );
+		shape->m_map = this;
+		if( definitions[defIdx].m_alignment == ALIGNMENT_PLAYER )
+		{
+			m_player = shape->m_handle;
+		}
+
+		uint rowIdx = m_shapeTables.Add();
+		WriteShapeState( rowIdx );
+		m_shapeTables.SnapPreviousState( rowIdx );
+		uint64_t cellKey = m_shapeGrid.GetCellKey( m_shapeTables.m_worldShapes[rowIdx].m_obb.m_center );
+		m_shapeTables.m_gridCells[rowIdx] = cellKey;
+		m_batchHandles.push_back( shape->m_handle );
+		m_batchCells.push_back( cellKey );
+	}
+	m_shapeGrid.InsertBatch( m_batchHandles, m_batchCells );
+}
+
+//--------------------------------------------------------------------------
+/**
+* RemoveShape
+* Frees the shape; any handle to it goes stale.
+*/
+void Map::RemoveShape( Shape* shape )
+{
+	uint denseIdx = m_shapes.GetDenseIndex( shape->m_handle );
+	if( m_shapes.Remove( shape->m_handle ) )
+	{
+		m_shapeGrid.Remove( shape->m_handle, m_shapeTables.m_gridCells[denseIdx] );
+		m_numAsleep -= m_shapeTables.HasFlag( denseIdx, SHAPE_FLAG_ASLEEP ) ? 1 : 0;
+		m_shapeTables.SwapRemove( denseIdx );
+		m_pillPool.Destroy( static_cast<Pill*>( shape ) );
+		m_areContactsStale = true;
 	}
 }
 
@@ -396,7 +2221,7 @@ void Map::RemoveShape( Shape* shape )
 */
 uint Map::GetNumShapes() const
 {
-	return (uint) m_shapes.size();
+	return m_shapes.GetCount();
 }
 
 //--------------------------------------------------------------------------
@@ -412,10 +2237,11 @@ void Map::UpdatePlayerPosAndCamera( float deltaSec )
 		m_camera->SetFocalPoint( Vec2( curPos.x + movement.x, curPos.y + movement.y ) );
 
 	}
-	else if ( m_player )
+	else if ( GetPlayer() )
 	{
 		// calc focus point
-		float speed = m_player->m_rigidbody->GetVelocity().GetLength();
+		Shape* player = GetPlayer();
+		float speed = player->m_rigidbody->GetVelocity().GetLength();
 
 		Vec2 movement = g_theGameController->GetFramePan() * deltaSec;
 		Vec3 right = m_camera->GetRight();
@@ -425,14 +2251,14 @@ void Map::UpdatePlayerPosAndCamera( float deltaSec )
 		flatForward.Normalize();
 		flatRight.Normalize();
 
-		if( m_player->m_preventInputTimer->HasElapsed() )
+		if( g_theApp->m_gameTimers->HasElapsed( player->m_preventInputTimer ) )
 		{
-			m_player->m_rigidbody->AddForce( ( flatForward * movement.y + flatRight * movement.x ) * m_player->m_speed );
+			player->AddForce( ( flatForward * movement.y + flatRight * movement.x ) * player->m_speed );
 		}
 		
 
 		Vec2 curPos = m_camera->m_focusPoint;
-		Vec2 lerpedPos = Lerp( curPos, m_player->GetPosition(), .7f * deltaSec * RangeMapFloat( speed, 0.0f, 5.0f, 1.0f, 5.0f ) );
+		Vec2 lerpedPos = Lerp( curPos, player->GetPosition(), .7f * deltaSec * RangeMapFloat( speed, 0.0f, 5.0f, 1.0f, 5.0f ) );
 		m_camera->SetFocalPoint( lerpedPos );
 	}
 	
@@ -2,6 +2,16 @@
 #include "Engine/Math/IntVec2.hpp"
 #include "Engine/Core/EngineCommon.hpp"
 #include "Game/FollowCamera2D.hpp"
+#include "Game/MapLoadJob.hpp"
+#include "Game/Shapes/ShapeSlotMap.hpp"
+#include "Game/Shapes/PillPool.hpp"
+#include "Game/Shapes/ShapeTables.hpp"
+#include "Game/Shapes/ShapeGrid.hpp"
+#include "Game/Shapes/ShapeBroadphase.hpp"
+#include "Game/Shapes/PillboxBatch.hpp"
+#include "Game/Shapes/PillboxSweep.hpp"
+#include "Game/TriggerField.hpp"
+#include "Engine/Core/Vertex_PCU.hpp"
 #include <vector>
 
 //--------------------------------------------------------------------------
@@ -15,6 +25,7 @@ class MeshGPU;
 class FollowCamera2D;
 class Shape;
 class Game;
+class MapSaveJob;
 
 //--------------------------------------------------------------------------
 
@@ -23,6 +34,81 @@ struct MapTile
 	int placeholder;
 };
 
+//--------------------------------------------------------------------------
+// Current state of a shape from the map file, whether or not its region is loaded.
+//--------------------------------------------------------------------------
+struct MapStreamShape
+{
+	ShapeDefinition m_definition;
+	bool m_isLive		= false;	// Has a Shape in m_shapes
+	bool m_isRemoved	= false;	// Destroyed in play; stays gone until respawn
+};
+
+//--------------------------------------------------------------------------
+// A shape's center crossing into or out of a trigger this frame.
+//--------------------------------------------------------------------------
+struct TriggerEvent
+{
+	ShapeHandle m_shape;
+	uint m_trigger;		// Index into the map's TriggerField
+	bool m_isEnter;
+};
+
+//--------------------------------------------------------------------------
+enum eContactEventType
+{
+	CONTACT_BEGIN,
+	CONTACT_PERSIST,
+	CONTACT_END,
+};
+
+//--------------------------------------------------------------------------
+// A pair of shapes starting, staying in or leaving contact over one physics
+// step. Either handle may be stale on an end event.
+//--------------------------------------------------------------------------
+struct ContactEvent
+{
+	ShapeHandle m_a;
+	ShapeHandle m_b;
+	eContactEventType m_type;
+	uint m_step			= 0;			// Which of the frame's physics steps, from 0
+	Vec2 m_normal		= Vec2::ZERO;	// From a toward b; zero on end
+	float m_impulse		= 0.0f;			// Estimated from the change in approach speed over the step
+};
+
+//--------------------------------------------------------------------------
+// A contact keyed by its two slots, lower slot first.
+//--------------------------------------------------------------------------
+struct ContactRecord
+{
+	uint64_t m_key;
+	ShapeHandle m_a;
+	ShapeHandle m_b;
+};
+
+//--------------------------------------------------------------------------
+// A continuous collision body's collider from before the current physics step.
+//--------------------------------------------------------------------------
+struct ContinuousBody
+{
+	uint m_row;
+	Pillbox2 m_start;
+};
+
+//--------------------------------------------------------------------------
+// Earliest touch found for a movable body during the current physics step.
+//--------------------------------------------------------------------------
+struct ContinuousHit
+{
+	uint m_row;
+	uint m_otherRow;
+	float m_time;			// Fraction of the step
+	Vec2 m_center;			// The body's center at the touch
+	Vec2 m_normal;			// Away from the other body
+	Vec2 m_otherVelocity;	// Of the other body's surface near the touch
+	Pillbox2 m_otherEnd;	// Where the other body finished the step
+};
+
 //--------------------------------------------------------------------------
 
 class Map
@@ -37,10 +123,24 @@ public:
 public:
 	bool Load( char const *filename );  
 	bool Save( const char* filePath );
+	void SaveAsync( const char* filePath, MapSaveJob& job );
+	bool LoadBinary( char const* filePath );
+	bool SaveBinary( char const* filePath ) const;
+
+	void BeginLoadAsync( char const* filename );
+	bool UpdateLoadAsync();
+	void CancelLoadAsync();
+	bool IsLoadingAsync() const;
+	float GetLoadProgress() const;
 	bool Create( int tileWidth, int tileHeight ); 
 
 	void Update( float deltaSec ); 
+	void BeginPhysicsStep();
+	void EndPhysicsStep( float stepSeconds );
 	void Render() const; 
+	void Respawn();
+
+	uint GetNumLoadedRegions() const;
 
 public:
 	bool IsLoaded() const;
@@ -48,6 +148,26 @@ public:
 public:
 	AABB2 GetXYBounds() const; 
 	FollowCamera2D* GetCamera() { return m_camera; }
+	Shape* GetShape( ShapeHandle handle ) const { return m_shapes.Get( handle ); }
+	Shape* GetPlayer() const { return m_shapes.Get( m_player ); }
+	bool HasShapeFlag( ShapeHandle handle, eShapeFlag flag ) const;
+	void SetShapeFlag( ShapeHandle handle, eShapeFlag flag, bool isSet );
+	void QueueDestroy( ShapeHandle handle );
+	void WakeShape( ShapeHandle handle );
+	void SetDeterministic( bool isDeterministic )	{ m_isDeterministic = isDeterministic; }
+	void SetShowingStats( bool isShowingStats )		{ m_isShowingStats = isShowingStats; }
+	bool IsDeterministic() const					{ return m_isDeterministic; }
+	uint64_t GetPhysicsStateHash() const;
+	uint64_t GetLastStepHash() const				{ return m_lastStepHash; }
+	const std::vector<ContactEvent>& GetContactEvents() const	{ return m_contactEvents; }
+	void SetEndZone( const Vec2& position );
+
+	// Spatial queries, as of the last physics step
+	Shape* QueryNearest( const Vec2& point, float maxDistance = 999999999.0f ) const;
+	Shape* QueryPoint( const Vec2& point ) const;
+	void QueryRadius( const Vec2& center, float radius, std::vector<Shape*>& out ) const;
+	void QueryAABB( const Vec2& mins, const Vec2& maxs, std::vector<Shape*>& out ) const;
+	float GetDistanceToShape( ShapeHandle handle, const Vec2& point ) const;
 
 private:
 	void RenderTerrain( Material* matOverride = nullptr ) const; 															
@@ -55,12 +175,59 @@ private:
 	int GetVertIndex( int x, int y );
 
 private:
-	void GarbageCollection();
+	void DestroyQueuedShapes();
+	void GatherShapeState();
+	void CapturePreviousShapeState();
+	void WriteShapeState( uint denseIdx );
+	void UpdateShapeCell( uint denseIdx );
+	void FindContacts();
+	void UpdateContactEvents();
+	void AddContactEvent( const ContactRecord& record, eContactEventType type );
+	void ProcessContactEvents();
+	void AddTouching( ShapeHandle handle, int delta );
+	void AddContinuousHit( uint rowIdx, const PillboxSweep& sweep, uint otherRow, const PillboxSweep& otherSweep, float time, float stepSeconds );
+	void ApplyContinuousHit( const ContinuousHit& hit );
+	void SpinKinematicBodies( float stepSeconds );
+	void PushFromKinematicBodies( float stepSeconds );
+	void UpdateSleeping( float physicsSeconds );
+	void SetAsleep( uint rowIdx, bool isAsleep );
+	uint AddIslandNode( uint rowIdx, uint8_t flags );
+	uint FindIslandNode( uint rowIdx );
+	void WakeSleepersInReach( float stepSeconds );
+	void WakeSleepersOverlapping( const Vec2& mins, const Vec2& maxs );
+	void RenderShapes() const;
+
+private:
+	// Triggers
+	void RebuildTriggerField();
+	void UpdateTriggers( float deltaSec );
+	bool DamagePlayer( float damage );
+	void RenderTriggers() const;
 
 
+private:
+	Shape* SpawnShape( const ShapeDefinition& definition );
+	ShapeDefinition GetShapeDefinition( const Shape* shape ) const;
+	void CaptureMapData( MapData& out, std::vector<Shape*>* outLiveShapes = nullptr ) const;
+	void SnapshotPristine();
+	bool FinishLoad();
+
+private:
+	// Region streaming
+	void BeginStreaming( MapData&& data );
+	void ResetStreamState();
+	void UpdateStreaming();
+	uint LoadRegionsAround( const Vec2& focus, uint maxToSpawn );
+	uint CountShapesAround( const Vec2& focus ) const;
+	uint LoadRegion( uint regionIdx );
+	void UnloadRegion( uint regionIdx );
+	float GetDistanceToRegion( uint regionIdx, const Vec2& point ) const;
+	Vec2 GetStartFocus() const;
+
 private:
 	void DeleteAllShapes();
-	void AddShape( Shape* shape );
+	ShapeHandle AddShape( Shape* shape );
+	void AddShapes( const ShapeDefinition* definitions, uint count, std::vector<Shape*>& outShapes );
 	void RemoveShape( Shape* shape );
 	uint GetNumShapes() const;
 
@@ -69,12 +236,86 @@ private:
 
 private:
 	// Gameplay
-	std::vector<Shape*> m_shapes;
-	Shape* m_player = nullptr;
+	PillPool m_pillPool;		// Owns every shape in m_shapes
+	ShapeSlotMap m_shapes;
+	ShapeTables m_shapeTables;	// Row per entry in m_shapes, same order
+	mutable std::vector<Vertex_PCU> m_shapeVerts;
+	ShapeGrid m_shapeGrid;
+	float m_maxShapeBoundRadius = 0.0f;		// Largest shape seen since the last clear; grows box queries
+	mutable std::vector<ShapeHandle> m_queryScratch;
+	std::vector<ShapeHandle> m_destroyQueue;	// Freed in DestroyQueuedShapes, after physics has stepped
+
+	// Overlapping pairs with at least one dynamic shape, as of the last gather
+	ShapeBroadphase m_broadphase;
+	std::vector<ShapePair> m_contacts;
+	PillboxPairBatch m_contactBatch;
+	std::vector<float> m_contactSeparations;
+	bool m_areContactsStale = false;	// Rows were removed or bodies reset since; the pairs' rows can't be trusted
+
+	// Contact changes from each of this frame's physics steps, in step order and
+	// sorted by slot pair within a step; handled and cleared in Update
+	std::vector<ContactEvent> m_contactEvents;
+	std::vector<ContactRecord> m_contactRecords;
+	std::vector<ContactRecord> m_prevContactRecords;	// As the last step left them
+	uint m_numEventSteps = 0;		// Steps whose events are in m_contactEvents
+
+	// Continuous collision, between BeginPhysicsStep and EndPhysicsStep
+	std::vector<ContinuousBody> m_continuousBodies;
+	std::vector<ContinuousHit> m_continuousHits;
+	std::vector<Shape*> m_continuousScratch;
+	uint m_numContinuousHits = 0;		// Since the last Update
+
+	// Kinematic bodies and their colliders from before they were turned this step
+	std::vector<ContinuousBody> m_kinematicBodies;
+	double m_physicsSeconds = 0.0;
+	uint m_numKinematicPushes = 0;		// Since the last Update
+
+	// Deterministic mode: results don't depend on batch position or broadphase
+	// sort history, and every physics step ends by hashing the rigidbodies
+	bool m_isDeterministic = false;
+	uint64_t m_lastStepHash = 0;
+	mutable std::vector<uint> m_hashOrder;
+
+	// Per-frame physics counters on screen; set by the physicsstats command
+	bool m_isShowingStats = false;
+
+	// Sleeping; scratch for grouping bodies into islands. Nodes are numbered as
+	// rows join, and m_islandNodes is left all NO_ISLAND_NODE between updates
+	static const uint NO_ISLAND_NODE = 0xFFFFFFFF;
+	std::vector<uint> m_islandNodes;		// Per row
+	std::vector<uint> m_islandRows;			// Per node, and the rest likewise
+	std::vector<uint> m_islandParents;
+	std::vector<uint8_t> m_islandFlags;
+	uint m_numAsleep = 0;					// Kept by SetAsleep
+	std::vector<Shape*> m_wakeScratch;
+	std::vector<uint> m_wakeRows;
+
+	// Scratch for batched spawning
+	std::vector<ShapeDefinition> m_batchDefinitions;
+	std::vector<uint> m_batchIndices;
+	std::vector<Shape*> m_batchShapes;
+	std::vector<ShapeHandle> m_batchHandles;
+	std::vector<uint64_t> m_batchCells;
+	ShapeHandle m_player;
 	Vec2 m_endZone = Vec2( 5.0f, 5.0f );
 	float m_endZoneRadius = 2.0f;
+
+	// The end zone is trigger 0, then the map file's triggers in order
+	TriggerField m_triggerField;
+	std::vector<TriggerEvent> m_triggerEvents;
+	mutable std::vector<uint> m_triggerScratch;
+	Vec2 m_checkpoint = Vec2::ZERO;
+	bool m_hasCheckpoint = false;
 	float m_camScale = 1.0f;
 
+	// Level as loaded; Respawn restores from this instead of re-reading the file
+	MapData m_pristine;
+	std::vector<Shape*> m_respawnScratch;
+
+	// Parallel to m_pristine.m_shapes / m_regions. Only regions near the camera have live shapes
+	std::vector<MapStreamShape> m_streamShapes;
+	std::vector<bool> m_regionLoaded;
+
 private: 
 	IntVec2 m_tileDimensions; 
 	IntVec2 m_vertDimensions; 
@@ -90,6 +331,12 @@ private:
 	RenderContext* m_renderContext = nullptr;
 	std::string m_filename = "";
 
+	// Async loading
+	MapLoadJob m_loadJob;
+	uint m_spawnIdx = 0;
+	uint m_spawnTotal = 0;
+	bool m_spawning = false;
+
 private:
 	bool m_hasLoaded = false;
 
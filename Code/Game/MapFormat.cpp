@@ -0,0 +1,1121 @@
+#define WIN32_LEAN_AND_MEAN		// Always #define this before #including <windows.h>
+#include <windows.h>
+#include "Game/MapFormat.hpp"
+#include "Game/GameCommon.hpp"
+#include "Game/MapXmlReader.hpp"
+#include <fstream>
+#include <string.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <map>
+
+//--------------------------------------------------------------------------
+// .map schema tables - which ShapeDefinition member each attribute lands in
+//--------------------------------------------------------------------------
+enum eMapFieldType
+{
+	MAP_FIELD_FLOAT,
+	MAP_FIELD_VEC2,
+	MAP_FIELD_BOOL,
+	MAP_FIELD_ALIGNMENT,
+	MAP_FIELD_BODY_TYPE,
+};
+
+struct MapFieldDesc
+{
+	char const* m_element;
+	char const* m_attribute;
+	eMapFieldType m_type;
+	size_t m_offset;
+};
+
+enum eMapElement : uint
+{
+	MAP_ELEMENT_TRANS		= 1 << 0,
+	MAP_ELEMENT_COLLIDER	= 1 << 1,
+	MAP_ELEMENT_RIGIDBODY	= 1 << 2,
+};
+
+struct MapEnumName
+{
+	char const* m_name;
+	int m_value;
+};
+
+static const MapFieldDesc s_shapeFields[] = 
+{
+	{ "trans",		"pos",				MAP_FIELD_VEC2,			offsetof( ShapeDefinition, m_position ) },
+	{ "trans",		"scale",			MAP_FIELD_VEC2,			offsetof( ShapeDefinition, m_scale ) },
+	{ "trans",		"rot",				MAP_FIELD_FLOAT,		offsetof( ShapeDefinition, m_rotation ) },
+	{ "trans",		"alignment",		MAP_FIELD_ALIGNMENT,	offsetof( ShapeDefinition, m_alignment ) },
+	{ "collider",	"radius",			MAP_FIELD_FLOAT,		offsetof( ShapeDefinition, m_radius ) },
+	{ "collider",	"extents",			MAP_FIELD_VEC2,			offsetof( ShapeDefinition, m_extents ) },
+	{ "collider",	"locCenter",		MAP_FIELD_VEC2,			offsetof( ShapeDefinition, m_localCenter ) },
+	{ "collider",	"locRight",			MAP_FIELD_VEC2,			offsetof( ShapeDefinition, m_localRight ) },
+	{ "rigidbody",	"type",				MAP_FIELD_BODY_TYPE,	offsetof( ShapeDefinition, m_bodyType ) },
+	{ "rigidbody",	"mass",				MAP_FIELD_FLOAT,		offsetof( ShapeDefinition, m_mass ) },
+	{ "rigidbody",	"restitution",		MAP_FIELD_FLOAT,		offsetof( ShapeDefinition, m_restitution ) },
+	{ "rigidbody",	"friction",			MAP_FIELD_FLOAT,		offsetof( ShapeDefinition, m_friction ) },
+	{ "rigidbody",	"drag",				MAP_FIELD_FLOAT,		offsetof( ShapeDefinition, m_drag ) },
+	{ "rigidbody",	"angularDrag",		MAP_FIELD_FLOAT,		offsetof( ShapeDefinition, m_angularDrag ) },
+	{ "rigidbody",	"angularVelocity",	MAP_FIELD_FLOAT,		offsetof( ShapeDefinition, m_angularVelocity ) },
+	{ "rigidbody",	"xRestricted",		MAP_FIELD_BOOL,			offsetof( ShapeDefinition, m_xRestricted ) },
+	{ "rigidbody",	"yRestricted",		MAP_FIELD_BOOL,			offsetof( ShapeDefinition, m_yRestricted ) },
+	{ "rigidbody",	"rotRestricted",	MAP_FIELD_BOOL,			offsetof( ShapeDefinition, m_rotRestricted ) },
+	{ "rigidbody",	"ccd",				MAP_FIELD_BOOL,			offsetof( ShapeDefinition, m_continuous ) },
+};
+
+static const MapEnumName s_alignmentNames[] = 
+{
+	{ "player",		ALIGNMENT_PLAYER },
+	{ "neutral",	ALIGNMENT_NEUTRAL },
+	{ "ally",		ALIGNMENT_ALLY },
+	{ "enemy",		ALIGNMENT_ENEMY },
+};
+
+static const MapEnumName s_bodyTypeNames[] = 
+{
+	{ "static",		SHAPE_BODY_STATIC },
+	{ "dynamic",	SHAPE_BODY_DYNAMIC },
+	{ "kinematic",	SHAPE_BODY_KINEMATIC },
+};
+
+static const MapEnumName s_triggerTypeNames[] = 
+{
+	{ "checkpoint",	TRIGGER_CHECKPOINT },
+	{ "endZone",	TRIGGER_END_ZONE },
+	{ "damage",		TRIGGER_DAMAGE },
+	{ "speed",		TRIGGER_SPEED },
+	{ "kill",		TRIGGER_KILL },
+};
+
+//--------------------------------------------------------------------------
+// <prototype id="..."> from the map's <prototypes> block. The id points into the file buffer.
+struct MapPrototype
+{
+	MapToken m_id;
+	ShapeDefinition m_definition;
+};
+
+//--------------------------------------------------------------------------
+// Helper
+static const MapPrototype* FindMapPrototype( const std::vector<MapPrototype>& prototypes, const MapToken& id )
+{
+	for( const MapPrototype& prototype : prototypes )
+	{
+		if( prototype.m_id.Equals( id ) )
+		{
+			return &prototype;
+		}
+	}
+	return nullptr;
+}
+
+//--------------------------------------------------------------------------
+// Helper
+// Values are always followed by their closing quote, so strtof stops in the buffer.
+static float ParseMapFloat( const char*& cursor, float defaultValue )
+{
+	char* parseEnd = nullptr;
+	float value = strtof( cursor, &parseEnd );
+	if( parseEnd == cursor )
+	{
+		return defaultValue;
+	}
+	cursor = parseEnd;
+	return value;
+}
+
+//--------------------------------------------------------------------------
+// Helper
+static void ParseMapVec2( const MapToken& value, Vec2& inOut )
+{
+	const char* cursor = value.m_begin;
+	inOut.x = ParseMapFloat( cursor, inOut.x );
+	if( cursor < value.m_end && *cursor == ',' )
+	{
+		++cursor;
+		inOut.y = ParseMapFloat( cursor, inOut.y );
+	}
+}
+
+//--------------------------------------------------------------------------
+// Helper
+template <size_t N>
+static int LookupMapEnum( const MapEnumName (&names)[N], const MapToken& value, int defaultValue )
+{
+	for( size_t nameIdx = 0; nameIdx < N; ++nameIdx )
+	{
+		if( value.Equals( names[nameIdx].m_name ) )
+		{
+			return names[nameIdx].m_value;
+		}
+	}
+	return defaultValue;
+}
+
+//--------------------------------------------------------------------------
+// Helper
+static void ParseMapField( ShapeDefinition& def, const MapFieldDesc& field, const MapToken& value )
+{
+	unsigned char* member = (unsigned char*) &def + field.m_offset;
+	switch( field.m_type )
+	{
+	case MAP_FIELD_FLOAT:
+	{
+		const char* cursor = value.m_begin;
+		*(float*) member = ParseMapFloat( cursor, *(float*) member );
+		break;
+	}
+	case MAP_FIELD_VEC2:
+		ParseMapVec2( value, *(Vec2*) member );
+		break;
+	case MAP_FIELD_BOOL:
+		*(bool*) member = value.Equals( "true" );
+		break;
+	case MAP_FIELD_ALIGNMENT:
+		*(eAlignment*) member = (eAlignment) LookupMapEnum( s_alignmentNames, value, ALIGNMENT_NEUTRAL );
+		break;
+	case MAP_FIELD_BODY_TYPE:
+		*(eShapeBodyType*) member = (eShapeBodyType) LookupMapEnum( s_bodyTypeNames, value, SHAPE_BODY_STATIC );
+		break;
+	default:
+		break;
+	}
+}
+
+//--------------------------------------------------------------------------
+// Helper
+static void ParseShapeChildElement( MapXmlReader& reader, ShapeDefinition& def )
+{
+	const MapToken& element = reader.GetTagName();
+	MapToken name;
+	MapToken value;
+	while( reader.NextAttribute( name, value ) )
+	{
+		for( const MapFieldDesc& field : s_shapeFields )
+		{
+			if( name.Equals( field.m_attribute ) && element.Equals( field.m_element ) )
+			{
+				ParseMapField( def, field, value );
+				break;
+			}
+		}
+	}
+}
+
+//--------------------------------------------------------------------------
+// Helper
+// <trigger type="" center="" radius="" value=""/>
+static void ParseTriggerElement( MapXmlReader& reader, MapData& out )
+{
+	out.m_triggers.emplace_back();
+	TriggerDefinition& trigger = out.m_triggers.back();
+	MapToken name;
+	MapToken value;
+	while( reader.NextAttribute( name, value ) )
+	{
+		const char* cursor = value.m_begin;
+		if( name.Equals( "type" ) )
+		{
+			trigger.m_type = (eTriggerType) LookupMapEnum( s_triggerTypeNames, value, TRIGGER_CHECKPOINT );
+		}
+		else if( name.Equals( "center" ) )
+		{
+			ParseMapVec2( value, trigger.m_center );
+		}
+		else if( name.Equals( "radius" ) )
+		{
+			trigger.m_radius = ParseMapFloat( cursor, trigger.m_radius );
+		}
+		else if( name.Equals( "value" ) )
+		{
+			trigger.m_value = ParseMapFloat( cursor, trigger.m_value );
+		}
+	}
+}
+
+//--------------------------------------------------------------------------
+// Helper
+template <size_t N>
+static char const* LookupMapEnumName( const MapEnumName (&names)[N], int value )
+{
+	for( size_t nameIdx = 0; nameIdx < N; ++nameIdx )
+	{
+		if( names[nameIdx].m_value == value )
+		{
+			return names[nameIdx].m_name;
+		}
+	}
+	return names[0].m_name;
+}
+
+//--------------------------------------------------------------------------
+// Helper
+// Shortest %g that reads back to the same float; 9 significant digits always does.
+static int FormatMapFloat( char* buffer, size_t bufferSize, float value )
+{
+	for( int precision = 6; precision < 9; ++precision )
+	{
+		int length = snprintf( buffer, bufferSize, "%.*g", precision, value );
+		if( strtof( buffer, nullptr ) == value )
+		{
+			return length;
+		}
+	}
+	return snprintf( buffer, bufferSize, "%.9g", value );
+}
+
+//--------------------------------------------------------------------------
+// Helper
+static void FormatMapVec2( char* buffer, size_t bufferSize, const Vec2& value )
+{
+	int length = FormatMapFloat( buffer, bufferSize, value.x );
+	buffer[length++] = ',';
+	FormatMapFloat( buffer + length, bufferSize - length, value.y );
+}
+
+//--------------------------------------------------------------------------
+// Helper
+static void FormatMapField( char* buffer, size_t bufferSize, const ShapeDefinition& def, const MapFieldDesc& field )
+{
+	const unsigned char* member = (const unsigned char*) &def + field.m_offset;
+	switch( field.m_type )
+	{
+	case MAP_FIELD_FLOAT:
+		FormatMapFloat( buffer, bufferSize, *(const float*) member );
+		break;
+	case MAP_FIELD_VEC2:
+		FormatMapVec2( buffer, bufferSize, *(const Vec2*) member );
+		break;
+	case MAP_FIELD_BOOL:
+		snprintf( buffer, bufferSize, "%s", *(const bool*) member ? "true" : "false" );
+		break;
+	case MAP_FIELD_ALIGNMENT:
+		snprintf( buffer, bufferSize, "%s", LookupMapEnumName( s_alignmentNames, *(const eAlignment*) member ) );
+		break;
+	case MAP_FIELD_BODY_TYPE:
+		snprintf( buffer, bufferSize, "%s", LookupMapEnumName( s_bodyTypeNames, *(const eShapeBodyType*) member ) );
+		break;
+	default:
+		buffer[0] = '\0';
+		break;
+	}
+}
+
+//--------------------------------------------------------------------------
+// Helper
+static size_t GetMapFieldSize( eMapFieldType type )
+{
+	switch( type )
+	{
+	case MAP_FIELD_FLOAT:		return sizeof( float );
+	case MAP_FIELD_VEC2:		return sizeof( Vec2 );
+	case MAP_FIELD_BOOL:		return sizeof( bool );
+	case MAP_FIELD_ALIGNMENT:	return sizeof( eAlignment );
+	case MAP_FIELD_BODY_TYPE:	return sizeof( eShapeBodyType );
+	default:					return 0;
+	}
+}
+
+//--------------------------------------------------------------------------
+// Helper
+static uint GetMapElementBit( const MapFieldDesc& field )
+{
+	if( strcmp( field.m_element, "trans" ) == 0 )
+	{
+		return MAP_ELEMENT_TRANS;
+	}
+	return strcmp( field.m_element, "collider" ) == 0 ? MAP_ELEMENT_COLLIDER : MAP_ELEMENT_RIGIDBODY;
+}
+
+//--------------------------------------------------------------------------
+// Helper
+static void GetPrototypeKey( std::string& out, const ShapeDefinition& def, uint elements )
+{
+	out.assign( 1, (char) elements );
+	for( const MapFieldDesc& field : s_shapeFields )
+	{
+		if( GetMapElementBit( field ) & elements )
+		{
+			out.append( (const char*) &def + field.m_offset, GetMapFieldSize( field.m_type ) );
+		}
+	}
+}
+
+//--------------------------------------------------------------------------
+// Helper
+// One line per element in the elements mask.
+static void WriteMapElements( std::ostream& file, const ShapeDefinition& def, char const* indent, uint elements )
+{
+	char value[64];
+	char const* element = nullptr;
+	for( const MapFieldDesc& field : s_shapeFields )
+	{
+		if( ( GetMapElementBit( field ) & elements ) == 0 )
+		{
+			continue;
+		}
+		if( !element || strcmp( element, field.m_element ) != 0 )
+		{
+			if( element )
+			{
+				file << "/>\n";
+			}
+			element = field.m_element;
+			file << indent << '<' << element;
+		}
+		FormatMapField( value, sizeof( value ), def, field );
+		file << ' ' << field.m_attribute << "=\"" << value << '"';
+	}
+	if( element )
+	{
+		file << "/>\n";
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* ReadMapFile
+* Prefers the compiled .mapb next to the xml when it is newer, otherwise parses
+* the xml and recompiles the .mapb from it. Safe to call from several threads at once.
+*/
+bool ReadMapFile( char const* filePath, MapData& out )
+{
+	std::string binaryPath = GetBinaryMapPath( filePath );
+	if( IsFileNewer( binaryPath.c_str(), filePath ) && ReadMapBinary( binaryPath.c_str(), out ) )
+	{
+		return true;
+	}
+
+	if( !ReadMapXml( filePath, out ) )
+	{
+		return false;
+	}
+	WriteMapBinaryCache( binaryPath.c_str(), out );
+	return true;
+}
+
+//--------------------------------------------------------------------------
+/**
+* WriteMapBinaryCache
+* Two reads of the same map can recompile its cache at the same time, so each
+* writes a file of its own and moves it over the cache; a reader sees either
+* the old .mapb or a whole new one.
+*/
+bool WriteMapBinaryCache( char const* filePath, const MapData& data )
+{
+	std::string tempPath = Stringf( "%s.%lu.tmp", filePath, (unsigned long) GetCurrentThreadId() );
+	if( !WriteMapBinary( tempPath.c_str(), data ) )
+	{
+		DeleteFileA( tempPath.c_str() );
+		return false;
+	}
+	return MoveFileOver( tempPath.c_str(), filePath );
+}
+
+//--------------------------------------------------------------------------
+/**
+* ReadMapXml
+* Streams the file through MapXmlReader; no DOM and no per-attribute strings.
+*/
+bool ReadMapXml( char const* filePath, MapData& out )
+{
+	MappedFile file;
+	if( !file.Open( filePath ) )
+	{
+		return false;
+	}
+
+	MapXmlReader reader( (const char*) file.GetData(), file.GetSize() );
+	if( !reader.NextTag() || reader.IsEndTag() || !reader.GetTagName().Equals( "map" ) )
+	{
+		return false;
+	}
+
+	MapToken name;
+	MapToken value;
+	out.m_endZone = Vec2( 5.0f, 5.0f );
+	out.m_regionSize = MAP_DEFAULT_REGION_SIZE;
+	while( reader.NextAttribute( name, value ) )
+	{
+		if( name.Equals( "endZone" ) )
+		{
+			ParseMapVec2( value, out.m_endZone );
+		}
+		else if( name.Equals( "regionSize" ) )
+		{
+			const char* cursor = value.m_begin;
+			out.m_regionSize = ParseMapFloat( cursor, MAP_DEFAULT_REGION_SIZE );
+		}
+	}
+
+	// Prototypes are parsed once; shapes that name one start from a copy of it
+	std::vector<MapPrototype> prototypes;
+	out.m_shapes.clear();
+	out.m_triggers.clear();
+	ShapeDefinition* current = nullptr;
+	while( reader.NextTag() )
+	{
+		const MapToken& tag = reader.GetTagName();
+		if( tag.Equals( "shape" ) )
+		{
+			current = nullptr;
+			if( reader.IsEndTag() )
+			{
+				continue;
+			}
+			out.m_shapes.emplace_back();
+			current = &out.m_shapes.back();
+			while( reader.NextAttribute( name, value ) )
+			{
+				if( name.Equals( "proto" ) )
+				{
+					const MapPrototype* prototype = FindMapPrototype( prototypes, value );
+					if( prototype )
+					{
+						*current = prototype->m_definition;
+					}
+				}
+			}
+		}
+		else if( tag.Equals( "prototype" ) )
+		{
+			current = nullptr;
+			if( reader.IsEndTag() )
+			{
+				continue;
+			}
+			prototypes.emplace_back();
+			current = &prototypes.back().m_definition;
+			while( reader.NextAttribute( name, value ) )
+			{
+				if( name.Equals( "id" ) )
+				{
+					prototypes.back().m_id = value;
+				}
+			}
+		}
+		else if( tag.Equals( "trigger" ) )
+		{
+			current = nullptr;
+			if( !reader.IsEndTag() )
+			{
+				ParseTriggerElement( reader, out );
+			}
+		}
+		else if( current && !reader.IsEndTag() )
+		{
+			ParseShapeChildElement( reader, *current );
+		}
+	}
+	if( reader.HasError() )
+	{
+		return false;
+	}
+	ConvertRestrictedSpinners( out.m_shapes );
+	BuildMapRegions( out );
+	return true;
+}
+
+//--------------------------------------------------------------------------
+/**
+* WriteMapXml
+* Writes one line at a time straight to the file. Shared collider and rigidbody
+* setups go out once as prototypes; shapes only carry what their prototype doesn't.
+*/
+bool WriteMapXml( char const* filePath, const MapData& data )
+{
+	std::ofstream file( filePath, std::ios::out | std::ios::trunc );
+	if( !file.is_open() )
+	{
+		return false;
+	}
+
+	char dims[64];
+	char endZone[64];
+	char regionSize[32];
+	FormatMapVec2( dims, sizeof( dims ), GetMapDimensions( data ) );
+	FormatMapVec2( endZone, sizeof( endZone ), data.m_endZone );
+	FormatMapFloat( regionSize, sizeof( regionSize ), data.m_regionSize );
+	file << "<map mapDims=\"" << dims << "\" endZone=\"" << endZone << "\" regionSize=\"" << regionSize << "\">\n";
+
+	// A collider + rigidbody setup shared by two or more shapes becomes a prototype.
+	// Failing that, a shared rigidbody on its own does and the collider stays inline.
+	std::map<std::string, int> keyCounts;
+	std::vector<std::string> shapeKeys( data.m_shapes.size() );
+	for( size_t shapeIdx = 0; shapeIdx < data.m_shapes.size(); ++shapeIdx )
+	{
+		GetPrototypeKey( shapeKeys[shapeIdx], data.m_shapes[shapeIdx], MAP_ELEMENT_COLLIDER | MAP_ELEMENT_RIGIDBODY );
+		++keyCounts[shapeKeys[shapeIdx]];
+	}
+	for( size_t shapeIdx = 0; shapeIdx < data.m_shapes.size(); ++shapeIdx )
+	{
+		if( keyCounts[shapeKeys[shapeIdx]] < 2 )
+		{
+			GetPrototypeKey( shapeKeys[shapeIdx], data.m_shapes[shapeIdx], MAP_ELEMENT_RIGIDBODY );
+			++keyCounts[shapeKeys[shapeIdx]];
+		}
+	}
+
+	std::map<std::string, int> keyToPrototype;
+	std::vector<int> shapePrototypes( data.m_shapes.size(), -1 );
+	for( size_t shapeIdx = 0; shapeIdx < data.m_shapes.size(); ++shapeIdx )
+	{
+		const std::string& key = shapeKeys[shapeIdx];
+		if( keyCounts[key] < 2 )
+		{
+			continue;
+		}
+		auto found = keyToPrototype.find( key );
+		if( found == keyToPrototype.end() )
+		{
+			if( keyToPrototype.empty() )
+			{
+				file << "    <prototypes>\n";
+			}
+			int prototypeIdx = (int) keyToPrototype.size();
+			found = keyToPrototype.emplace( key, prototypeIdx ).first;
+			file << "        <prototype id=\"p" << prototypeIdx << "\">\n";
+			WriteMapElements( file, data.m_shapes[shapeIdx], "            ", (uint) key[0] );
+			file << "        </prototype>\n";
+		}
+		shapePrototypes[shapeIdx] = found->second;
+	}
+	if( !keyToPrototype.empty() )
+	{
+		file << "    </prototypes>\n";
+	}
+
+	if( !data.m_triggers.empty() )
+	{
+		file << "    <triggers>\n";
+		for( const TriggerDefinition& trigger : data.m_triggers )
+		{
+			char center[64];
+			char radius[32];
+			char value[32];
+			FormatMapVec2( center, sizeof( center ), trigger.m_center );
+			FormatMapFloat( radius, sizeof( radius ), trigger.m_radius );
+			FormatMapFloat( value, sizeof( value ), trigger.m_value );
+			file << "        <trigger type=\"" << LookupMapEnumName( s_triggerTypeNames, trigger.m_type ) << "\" center=\"" << center
+				<< "\" radius=\"" << radius << "\" value=\"" << value << "\"/>\n";
+		}
+		file << "    </triggers>\n";
+	}
+
+	for( size_t shapeIdx = 0; shapeIdx < data.m_shapes.size(); ++shapeIdx )
+	{
+		uint inlineElements = MAP_ELEMENT_TRANS | MAP_ELEMENT_COLLIDER | MAP_ELEMENT_RIGIDBODY;
+		if( shapePrototypes[shapeIdx] >= 0 )
+		{
+			inlineElements &= ~(uint) shapeKeys[shapeIdx][0];
+			file << "    <shape proto=\"p" << shapePrototypes[shapeIdx] << "\">\n";
+		}
+		else
+		{
+			file << "    <shape>\n";
+		}
+		WriteMapElements( file, data.m_shapes[shapeIdx], "        ", inlineElements );
+		file << "    </shape>\n";
+	}
+	file << "</map>\n";
+	return file.good();
+}
+
+//--------------------------------------------------------------------------
+/**
+* IsShapeDefinitionBitIdentical
+* Compares every serialized field bit for bit, so 0 and -0 or two NaNs are told apart correctly.
+*/
+bool IsShapeDefinitionBitIdentical( const ShapeDefinition& a, const ShapeDefinition& b )
+{
+	for( const MapFieldDesc& field : s_shapeFields )
+	{
+		if( memcmp( (const unsigned char*) &a + field.m_offset, (const unsigned char*) &b + field.m_offset, GetMapFieldSize( field.m_type ) ) != 0 )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+//--------------------------------------------------------------------------
+/**
+* IsTriggerDefinitionBitIdentical
+*/
+bool IsTriggerDefinitionBitIdentical( const TriggerDefinition& a, const TriggerDefinition& b )
+{
+	return a.m_type == b.m_type
+		&& memcmp( &a.m_center, &b.m_center, sizeof( Vec2 ) ) == 0
+		&& memcmp( &a.m_radius, &b.m_radius, sizeof( float ) ) == 0
+		&& memcmp( &a.m_value, &b.m_value, sizeof( float ) ) == 0;
+}
+
+//--------------------------------------------------------------------------
+/**
+* ReadMapBinary
+* Maps the compiled file and copies the records straight out of the view.
+*/
+bool ReadMapBinary( char const* filePath, MapData& out )
+{
+	MappedFile file;
+	if( !file.Open( filePath ) || file.GetSize() < sizeof( MapBinaryHeader ) )
+	{
+		return false;
+	}
+
+	const MapBinaryHeader* header = (const MapBinaryHeader*) file.GetData();
+	if( header->m_magic != MAP_BINARY_MAGIC 
+		|| header->m_version != MAP_BINARY_VERSION 
+		|| header->m_recordSize != sizeof( MapShapeRecord )
+		|| file.GetSize() < sizeof( MapBinaryHeader ) + (size_t) header->m_numRegions * sizeof( MapRegionRecord ) 
+			+ (size_t) header->m_numShapes * sizeof( MapShapeRecord ) + (size_t) header->m_numTriggers * sizeof( MapTriggerRecord ) )
+	{
+		return false;
+	}
+
+	out.m_endZone = Vec2( header->m_endZone[0], header->m_endZone[1] );
+	out.m_regionSize = header->m_regionSize;
+	out.m_regions.resize( header->m_numRegions );
+	out.m_shapes.resize( header->m_numShapes );
+	out.m_triggers.resize( header->m_numTriggers );
+
+	const MapRegionRecord* regions = (const MapRegionRecord*) ( file.GetData() + sizeof( MapBinaryHeader ) );
+	for( uint regionIdx = 0; regionIdx < header->m_numRegions; ++regionIdx )
+	{
+		const MapRegionRecord& record = regions[regionIdx];
+		if( record.m_firstShape > header->m_numShapes || record.m_numShapes > header->m_numShapes - record.m_firstShape )
+		{
+			return false;
+		}
+		MapRegion& region = out.m_regions[regionIdx];
+		region.m_coords		= IntVec2( record.m_coords[0], record.m_coords[1] );
+		region.m_firstShape	= record.m_firstShape;
+		region.m_numShapes	= record.m_numShapes;
+	}
+
+	const MapShapeRecord* records = (const MapShapeRecord*) ( regions + header->m_numRegions );
+	for( uint recordIdx = 0; recordIdx < header->m_numShapes; ++recordIdx )
+	{
+		FillShapeDefinition( out.m_shapes[recordIdx], records[recordIdx] );
+	}
+
+	const MapTriggerRecord* triggers = (const MapTriggerRecord*) ( records + header->m_numShapes );
+	for( uint triggerIdx = 0; triggerIdx < header->m_numTriggers; ++triggerIdx )
+	{
+		const MapTriggerRecord& record = triggers[triggerIdx];
+		TriggerDefinition& trigger = out.m_triggers[triggerIdx];
+		trigger.m_type		= record.m_type < NUM_TRIGGER_TYPES ? (eTriggerType) record.m_type : TRIGGER_CHECKPOINT;
+		trigger.m_center	= Vec2( record.m_center[0], record.m_center[1] );
+		trigger.m_radius	= record.m_radius;
+		trigger.m_value		= record.m_value;
+	}
+	ConvertRestrictedSpinners( out.m_shapes );
+	return true;
+}
+
+//--------------------------------------------------------------------------
+/**
+* WriteMapBinary
+*/
+bool WriteMapBinary( char const* filePath, const MapData& data )
+{
+	// Region runs have to match the shape order, so group a copy rather than trust the caller
+	MapData grouped = data;
+	BuildMapRegions( grouped );
+
+	std::vector<MapRegionRecord> regions( grouped.m_regions.size() );
+	for( size_t regionIdx = 0; regionIdx < grouped.m_regions.size(); ++regionIdx )
+	{
+		const MapRegion& region = grouped.m_regions[regionIdx];
+		regions[regionIdx].m_coords[0]	= region.m_coords.x;
+		regions[regionIdx].m_coords[1]	= region.m_coords.y;
+		regions[regionIdx].m_firstShape	= region.m_firstShape;
+		regions[regionIdx].m_numShapes	= region.m_numShapes;
+	}
+
+	std::vector<MapShapeRecord> records( grouped.m_shapes.size() );
+	for( size_t shapeIdx = 0; shapeIdx < grouped.m_shapes.size(); ++shapeIdx )
+	{
+		FillShapeRecord( records[shapeIdx], grouped.m_shapes[shapeIdx] );
+	}
+
+	std::vector<MapTriggerRecord> triggers( grouped.m_triggers.size() );
+	for( size_t triggerIdx = 0; triggerIdx < grouped.m_triggers.size(); ++triggerIdx )
+	{
+		const TriggerDefinition& trigger = grouped.m_triggers[triggerIdx];
+		MapTriggerRecord& record = triggers[triggerIdx];
+		memset( &record, 0, sizeof( record ) );
+		record.m_center[0]	= trigger.m_center.x;
+		record.m_center[1]	= trigger.m_center.y;
+		record.m_radius		= trigger.m_radius;
+		record.m_value		= trigger.m_value;
+		record.m_type		= (uint8_t) trigger.m_type;
+	}
+
+	MapBinaryHeader header;
+	header.m_magic		= MAP_BINARY_MAGIC;
+	header.m_version	= MAP_BINARY_VERSION;
+	header.m_recordSize	= sizeof( MapShapeRecord );
+	header.m_numShapes	= (uint32_t) records.size();
+	header.m_numRegions	= (uint32_t) regions.size();
+	header.m_numTriggers	= (uint32_t) triggers.size();
+	header.m_regionSize	= grouped.m_regionSize;
+	header.m_endZone[0]	= grouped.m_endZone.x;
+	header.m_endZone[1]	= grouped.m_endZone.y;
+	Vec2 dims = GetMapDimensions( grouped );
+	header.m_mapDims[0]	= dims.x;
+	header.m_mapDims[1]	= dims.y;
+
+	std::ofstream file( filePath, std::ios::out | std::ios::binary | std::ios::trunc );
+	if( !file.is_open() )
+	{
+		return false;
+	}
+	file.write( (const char*) &header, sizeof( header ) );
+	if( !regions.empty() )
+	{
+		file.write( (const char*) regions.data(), regions.size() * sizeof( MapRegionRecord ) );
+	}
+	if( !records.empty() )
+	{
+		file.write( (const char*) records.data(), records.size() * sizeof( MapShapeRecord ) );
+	}
+	if( !triggers.empty() )
+	{
+		file.write( (const char*) triggers.data(), triggers.size() * sizeof( MapTriggerRecord ) );
+	}
+	return file.good();
+}
+
+//--------------------------------------------------------------------------
+/**
+* BuildMapRegions
+* Stable sorts the shapes by the region they sit in (row major) and rebuilds m_regions.
+* outOrder, if given, gets the old index of each shape in the new order.
+*/
+void BuildMapRegions( MapData& data, std::vector<uint>* outOrder )
+{
+	if( !( data.m_regionSize > 0.0f ) )
+	{
+		data.m_regionSize = MAP_DEFAULT_REGION_SIZE;
+	}
+
+	uint numShapes = (uint) data.m_shapes.size();
+	std::vector<IntVec2> coords( numShapes );
+	std::vector<uint> order( numShapes );
+	for( uint shapeIdx = 0; shapeIdx < numShapes; ++shapeIdx )
+	{
+		coords[shapeIdx] = GetMapRegionCoords( data.m_shapes[shapeIdx].m_position, data.m_regionSize );
+		order[shapeIdx] = shapeIdx;
+	}
+	std::stable_sort( order.begin(), order.end(), [&]( uint a, uint b )
+	{
+		return coords[a].y != coords[b].y ? coords[a].y < coords[b].y : coords[a].x < coords[b].x;
+	} );
+
+	std::vector<ShapeDefinition> sorted;
+	sorted.reserve( numShapes );
+	data.m_regions.clear();
+	for( uint shapeIdx = 0; shapeIdx < numShapes; ++shapeIdx )
+	{
+		const IntVec2& shapeCoords = coords[order[shapeIdx]];
+		if( data.m_regions.empty() || data.m_regions.back().m_coords.x != shapeCoords.x || data.m_regions.back().m_coords.y != shapeCoords.y )
+		{
+			data.m_regions.emplace_back();
+			data.m_regions.back().m_coords = shapeCoords;
+			data.m_regions.back().m_firstShape = shapeIdx;
+		}
+		++data.m_regions.back().m_numShapes;
+		sorted.push_back( data.m_shapes[order[shapeIdx]] );
+	}
+	data.m_shapes.swap( sorted );
+
+	if( outOrder )
+	{
+		outOrder->swap( order );
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* GetMapRegionCoords
+*/
+IntVec2 GetMapRegionCoords( const Vec2& position, float regionSize )
+{
+	// Clamped so a stray huge or nan position still lands in some region
+	constexpr float COORD_LIMIT = 1.0e9f;
+	float x = floorf( position.x / regionSize );
+	float y = floorf( position.y / regionSize );
+	x = x > -COORD_LIMIT ? ( x < COORD_LIMIT ? x : COORD_LIMIT ) : -COORD_LIMIT;
+	y = y > -COORD_LIMIT ? ( y < COORD_LIMIT ? y : COORD_LIMIT ) : -COORD_LIMIT;
+	return IntVec2( (int) x, (int) y );
+}
+
+//--------------------------------------------------------------------------
+/**
+* GetMapDimensions
+* Width and height of the smallest block of regions holding every region in
+* data.m_regions, which must be built. Zero for a map with no shapes.
+*/
+Vec2 GetMapDimensions( const MapData& data )
+{
+	if( data.m_regions.empty() )
+	{
+		return Vec2::ZERO;
+	}
+	IntVec2 mins = data.m_regions.front().m_coords;
+	IntVec2 maxs = mins;
+	for( const MapRegion& region: data.m_regions )
+	{
+		mins.x = region.m_coords.x < mins.x ? region.m_coords.x : mins.x;
+		mins.y = region.m_coords.y < mins.y ? region.m_coords.y : mins.y;
+		maxs.x = region.m_coords.x > maxs.x ? region.m_coords.x : maxs.x;
+		maxs.y = region.m_coords.y > maxs.y ? region.m_coords.y : maxs.y;
+	}
+	return Vec2( (float) ( maxs.x - mins.x + 1 ), (float) ( maxs.y - mins.y + 1 ) ) * data.m_regionSize;
+}
+
+//--------------------------------------------------------------------------
+/**
+* FillShapeRecord
+*/
+void FillShapeRecord( MapShapeRecord& out, const ShapeDefinition& definition )
+{
+	out.m_position[0]		= definition.m_position.x;
+	out.m_position[1]		= definition.m_position.y;
+	out.m_scale[0]			= definition.m_scale.x;
+	out.m_scale[1]			= definition.m_scale.y;
+	out.m_rotation			= definition.m_rotation;
+
+	out.m_radius			= definition.m_radius;
+	out.m_extents[0]		= definition.m_extents.x;
+	out.m_extents[1]		= definition.m_extents.y;
+	out.m_localCenter[0]	= definition.m_localCenter.x;
+	out.m_localCenter[1]	= definition.m_localCenter.y;
+	out.m_localRight[0]		= definition.m_localRight.x;
+	out.m_localRight[1]		= definition.m_localRight.y;
+
+	out.m_mass				= definition.m_mass;
+	out.m_restitution		= definition.m_restitution;
+	out.m_friction			= definition.m_friction;
+	out.m_drag				= definition.m_drag;
+	out.m_angularDrag		= definition.m_angularDrag;
+	out.m_angularVelocity	= definition.m_angularVelocity;
+
+	out.m_bodyType			= (uint8_t) definition.m_bodyType;
+	out.m_alignment			= (uint8_t) definition.m_alignment;
+	out.m_restrictions		= (uint8_t) ( ( definition.m_xRestricted ? MAP_RESTRICT_X : 0 )
+							| ( definition.m_yRestricted ? MAP_RESTRICT_Y : 0 )
+							| ( definition.m_rotRestricted ? MAP_RESTRICT_ROT : 0 ) );
+	out.m_options			= (uint8_t) ( definition.m_continuous ? MAP_OPTION_CONTINUOUS : 0 );
+}
+
+//--------------------------------------------------------------------------
+/**
+* FillShapeDefinition
+*/
+void FillShapeDefinition( ShapeDefinition& out, const MapShapeRecord& record )
+{
+	out.m_position			= Vec2( record.m_position[0], record.m_position[1] );
+	out.m_scale				= Vec2( record.m_scale[0], record.m_scale[1] );
+	out.m_rotation			= record.m_rotation;
+	out.m_alignment			= record.m_alignment <= ALIGNMENT_ENEMY ? (eAlignment) record.m_alignment : ALIGNMENT_NEUTRAL;
+
+	out.m_radius			= record.m_radius;
+	out.m_extents			= Vec2( record.m_extents[0], record.m_extents[1] );
+	out.m_localCenter		= Vec2( record.m_localCenter[0], record.m_localCenter[1] );
+	out.m_localRight		= Vec2( record.m_localRight[0], record.m_localRight[1] );
+
+	out.m_bodyType			= record.m_bodyType <= SHAPE_BODY_KINEMATIC ? (eShapeBodyType) record.m_bodyType : SHAPE_BODY_STATIC;
+	out.m_mass				= record.m_mass;
+	out.m_restitution		= record.m_restitution;
+	out.m_friction			= record.m_friction;
+	out.m_drag				= record.m_drag;
+	out.m_angularDrag		= record.m_angularDrag;
+	out.m_angularVelocity	= record.m_angularVelocity;
+	out.m_xRestricted		= ( record.m_restrictions & MAP_RESTRICT_X ) != 0;
+	out.m_yRestricted		= ( record.m_restrictions & MAP_RESTRICT_Y ) != 0;
+	out.m_rotRestricted		= ( record.m_restrictions & MAP_RESTRICT_ROT ) != 0;
+	out.m_continuous		= ( record.m_options & MAP_OPTION_CONTINUOUS ) != 0;
+}
+
+//--------------------------------------------------------------------------
+/**
+* ConvertRestrictedSpinners
+* Older maps fake spinners with dynamic bodies pinned in x and y that turn at a
+* constant rate. Those become kinematic; region order is unchanged.
+*/
+void ConvertRestrictedSpinners( std::vector<ShapeDefinition>& definitions )
+{
+	for( ShapeDefinition& definition: definitions )
+	{
+		if( definition.m_bodyType == SHAPE_BODY_DYNAMIC && definition.m_xRestricted && definition.m_yRestricted && !definition.m_rotRestricted
+			&& definition.m_angularVelocity != 0.0f && definition.m_angularDrag == 0.0f )
+		{
+			definition.m_bodyType = SHAPE_BODY_KINEMATIC;
+		}
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* GetBinaryMapPath
+* "Data/Saved/map1.map" -> "Data/Saved/map1.mapb"
+*/
+std::string GetBinaryMapPath( const std::string& xmlPath )
+{
+	size_t dot = xmlPath.find_last_of( '.' );
+	size_t slash = xmlPath.find_last_of( "/\\" );
+	if( dot == std::string::npos || ( slash != std::string::npos && dot < slash ) )
+	{
+		return xmlPath + MAP_BINARY_EXTENSION;
+	}
+	return xmlPath.substr( 0, dot ) + MAP_BINARY_EXTENSION;
+}
+
+//--------------------------------------------------------------------------
+/**
+* IsFileNewer
+* False if filePath doesn't exist; true if comparedToPath doesn't exist.
+*/
+bool IsFileNewer( char const* filePath, char const* comparedToPath )
+{
+	WIN32_FILE_ATTRIBUTE_DATA fileData;
+	if( !GetFileAttributesExA( filePath, GetFileExInfoStandard, &fileData ) )
+	{
+		return false;
+	}
+
+	WIN32_FILE_ATTRIBUTE_DATA comparedToData;
+	if( !GetFileAttributesExA( comparedToPath, GetFileExInfoStandard, &comparedToData ) )
+	{
+		return true;
+	}
+
+	return CompareFileTime( &fileData.ftLastWriteTime, &comparedToData.ftLastWriteTime ) > 0;
+}
+
+//--------------------------------------------------------------------------
+/**
+* MoveFileOver
+* Replaces toPath with fromPath in one step; fromPath is deleted if that fails.
+*/
+bool MoveFileOver( char const* fromPath, char const* toPath )
+{
+	if( !MoveFileExA( fromPath, toPath, MOVEFILE_REPLACE_EXISTING ) )
+	{
+		DeleteFileA( fromPath );
+		return false;
+	}
+	return true;
+}
+
+//--------------------------------------------------------------------------
+/**
+* GetFilesInFolder
+* Returns "folder/name.ext" for every file directly in folder ending with extension.
+*/
+std::vector<std::string> GetFilesInFolder( char const* folder, char const* extension )
+{
+	std::vector<std::string> files;
+	std::string search = Stringf( "%s/*%s", folder, extension );
+	size_t extensionLength = strlen( extension );
+
+	WIN32_FIND_DATAA findData;
+	HANDLE find = FindFirstFileA( search.c_str(), &findData );
+	if( find == INVALID_HANDLE_VALUE )
+	{
+		return files;
+	}
+	do 
+	{
+		// "*.map" also matches ".mapb" through 8.3 short names, so check the real extension.
+		size_t nameLength = strlen( findData.cFileName );
+		if( !( findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ) 
+			&& nameLength >= extensionLength 
+			&& strcmp( findData.cFileName + nameLength - extensionLength, extension ) == 0 )
+		{
+			files.push_back( Stringf( "%s/%s", folder, findData.cFileName ) );
+		}
+	} while( FindNextFileA( find, &findData ) );
+	FindClose( find );
+	return files;
+}
+
+//--------------------------------------------------------------------------
+/**
+* ~MappedFile
+*/
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+//--------------------------------------------------------------------------
+/**
+* Open
+*/
+bool MappedFile::Open( char const* filePath )
+{
+	Close();
+
+	HANDLE file = CreateFileA( filePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+	if( file == INVALID_HANDLE_VALUE )
+	{
+		return false;
+	}
+	m_fileHandle = file;
+
+	LARGE_INTEGER size;
+	if( !GetFileSizeEx( file, &size ) || size.QuadPart == 0 )
+	{
+		Close();
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA( file, NULL, PAGE_READONLY, 0, 0, NULL );
+	if( mapping == NULL )
+	{
+		Close();
+		return false;
+	}
+	m_mappingHandle = mapping;
+
+	m_data = (const unsigned char*) MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+	if( !m_data )
+	{
+		Close();
+		return false;
+	}
+	m_size = (size_t) size.QuadPart;
+	return true;
+}
+
+//--------------------------------------------------------------------------
+/**
+* Close
+*/
+void MappedFile::Close()
+{
+	if( m_data )
+	{
+		UnmapViewOfFile( m_data );
+		m_data = nullptr;
+	}
+	if( m_mappingHandle )
+	{
+		CloseHandle( (HANDLE) m_mappingHandle );
+		m_mappingHandle = nullptr;
+	}
+	if( m_fileHandle )
+	{
+		CloseHandle( (HANDLE) m_fileHandle );
+		m_fileHandle = nullptr;
+	}
+	m_size = 0;
+}
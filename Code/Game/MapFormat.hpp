@@ -0,0 +1,161 @@
+#pragma once
+#include "Engine/Core/EngineCommon.hpp"
+#include "Engine/Math/IntVec2.hpp"
+#include "Game/Shapes/ShapeDefinition.hpp"
+#include "Game/TriggerDefinition.hpp"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+//--------------------------------------------------------------------------
+// Compiled (binary) map format
+// [MapBinaryHeader][MapRegionRecord * m_numRegions][MapShapeRecord * m_numShapes][MapTriggerRecord * m_numTriggers]
+// Records are read in place out of a memory-mapped view, so everything is
+// 4 byte aligned and fixed size. Bump MAP_BINARY_VERSION on any layout change.
+// Shape records are grouped by region; each region record indexes its run.
+//--------------------------------------------------------------------------
+constexpr uint32_t MAP_BINARY_MAGIC		= 0x504D444C; // "LDMP"
+constexpr uint32_t MAP_BINARY_VERSION	= 4;
+constexpr char const* MAP_BINARY_EXTENSION = ".mapb";
+constexpr float MAP_DEFAULT_REGION_SIZE	= 16.0f;
+
+enum eMapRecordRestriction : uint8_t
+{
+	MAP_RESTRICT_X		= 1 << 0,
+	MAP_RESTRICT_Y		= 1 << 1,
+	MAP_RESTRICT_ROT	= 1 << 2,
+};
+
+enum eMapRecordOption : uint8_t
+{
+	MAP_OPTION_CONTINUOUS	= 1 << 0,
+};
+
+struct MapBinaryHeader
+{
+	uint32_t m_magic;
+	uint32_t m_version;
+	uint32_t m_recordSize;
+	uint32_t m_numShapes;
+	uint32_t m_numRegions;
+	uint32_t m_numTriggers;
+	float m_regionSize;
+	float m_endZone[2];
+	float m_mapDims[2];			// GetMapDimensions; informational, not read back
+};
+static_assert( sizeof( MapBinaryHeader ) == 44, "MapBinaryHeader layout changed; bump MAP_BINARY_VERSION" );
+
+struct MapRegionRecord
+{
+	int32_t m_coords[2];
+	uint32_t m_firstShape;
+	uint32_t m_numShapes;
+};
+static_assert( sizeof( MapRegionRecord ) == 16, "MapRegionRecord layout changed; bump MAP_BINARY_VERSION" );
+
+struct MapShapeRecord
+{
+	// Trans
+	float m_position[2];
+	float m_scale[2];
+	float m_rotation;
+
+	// Collider
+	float m_radius;
+	float m_extents[2];
+	float m_localCenter[2];
+	float m_localRight[2];
+
+	// Rigidbody
+	float m_mass;
+	float m_restitution;
+	float m_friction;
+	float m_drag;
+	float m_angularDrag;
+	float m_angularVelocity;
+
+	uint8_t m_bodyType;			// eShapeBodyType
+	uint8_t m_alignment;		// eAlignment
+	uint8_t m_restrictions;		// eMapRecordRestriction bits
+	uint8_t m_options;			// eMapRecordOption bits
+};
+static_assert( sizeof( MapShapeRecord ) == 76, "MapShapeRecord layout changed; bump MAP_BINARY_VERSION" );
+
+struct MapTriggerRecord
+{
+	float m_center[2];
+	float m_radius;
+	float m_value;
+	uint8_t m_type;				// eTriggerType
+	uint8_t m_padding[3];
+};
+static_assert( sizeof( MapTriggerRecord ) == 20, "MapTriggerRecord layout changed; bump MAP_BINARY_VERSION" );
+
+//--------------------------------------------------------------------------
+// Square cell of the level, m_regionSize on a side. Covers the run
+// [m_firstShape, m_firstShape + m_numShapes) of MapData::m_shapes.
+//--------------------------------------------------------------------------
+struct MapRegion
+{
+	IntVec2 m_coords;
+	uint m_firstShape	= 0;
+	uint m_numShapes	= 0;
+};
+
+//--------------------------------------------------------------------------
+// Everything read out of a map file, before any shapes or rigidbodies exist.
+// Safe to build off the main thread. Readers hand it back region sorted.
+//--------------------------------------------------------------------------
+struct MapData
+{
+	Vec2 m_endZone = Vec2( 5.0f, 5.0f );
+	float m_regionSize = MAP_DEFAULT_REGION_SIZE;
+	std::vector<ShapeDefinition> m_shapes;
+	std::vector<MapRegion> m_regions;
+	std::vector<TriggerDefinition> m_triggers;	// Besides the end zone
+};
+
+bool ReadMapFile( char const* filePath, MapData& out );
+bool ReadMapXml( char const* filePath, MapData& out );
+bool WriteMapXml( char const* filePath, const MapData& data );
+bool ReadMapBinary( char const* filePath, MapData& out );
+bool WriteMapBinary( char const* filePath, const MapData& data );
+bool WriteMapBinaryCache( char const* filePath, const MapData& data );
+void BuildMapRegions( MapData& data, std::vector<uint>* outOrder = nullptr );
+IntVec2 GetMapRegionCoords( const Vec2& position, float regionSize );
+Vec2 GetMapDimensions( const MapData& data );
+
+//--------------------------------------------------------------------------
+void FillShapeRecord( MapShapeRecord& out, const ShapeDefinition& definition );
+void FillShapeDefinition( ShapeDefinition& out, const MapShapeRecord& record );
+void ConvertRestrictedSpinners( std::vector<ShapeDefinition>& definitions );
+bool IsShapeDefinitionBitIdentical( const ShapeDefinition& a, const ShapeDefinition& b );
+bool IsTriggerDefinitionBitIdentical( const TriggerDefinition& a, const TriggerDefinition& b );
+
+std::string GetBinaryMapPath( const std::string& xmlPath );
+bool IsFileNewer( char const* filePath, char const* comparedToPath );
+bool MoveFileOver( char const* fromPath, char const* toPath );
+std::vector<std::string> GetFilesInFolder( char const* folder, char const* extension );
+
+//--------------------------------------------------------------------------
+// Read only memory-mapped view of a whole file.
+//--------------------------------------------------------------------------
+class MappedFile
+{
+public:
+	MappedFile() {}
+	~MappedFile();
+
+public:
+	bool Open( char const* filePath );
+	void Close();
+
+	const unsigned char* GetData() const	{ return m_data; }
+	size_t GetSize() const					{ return m_size; }
+
+private:
+	void* m_fileHandle			= nullptr;
+	void* m_mappingHandle		= nullptr;
+	const unsigned char* m_data = nullptr;
+	size_t m_size				= 0;
+};
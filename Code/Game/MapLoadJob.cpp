@@ -0,0 +1,37 @@
+#include "Game/MapLoadJob.hpp"
+
+//--------------------------------------------------------------------------
+/**
+* Start
+* A read still running is canceled rather than waited for.
+*/
+void MapLoadJob::Start( const std::string& filename )
+{
+	Cancel();
+	m_filename = filename;
+	std::shared_ptr<MapData> data = m_data;
+	m_job.Start( [filename, data]() { return ReadMapFile( filename.c_str(), *data ); } );
+}
+
+//--------------------------------------------------------------------------
+/**
+* Reset
+*/
+void MapLoadJob::Reset()
+{
+	m_job.Reset();
+	m_filename.clear();
+	m_data = std::make_shared<MapData>();
+}
+
+//--------------------------------------------------------------------------
+/**
+* Cancel
+* Returns straight away; the read is left to finish into data nobody looks at.
+*/
+void MapLoadJob::Cancel()
+{
+	m_job.Cancel();
+	m_filename.clear();
+	m_data = std::make_shared<MapData>();
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "Game/BackgroundJob.hpp"
+#include "Game/MapFormat.hpp"
+#include <memory>
+#include <string>
+
+//--------------------------------------------------------------------------
+// Reads one map file into a MapData on a worker thread.
+// Only the owner thread touches the job; poll IsFinished() then Join().
+//--------------------------------------------------------------------------
+class MapLoadJob
+{
+public:
+	MapLoadJob() : m_data( std::make_shared<MapData>() ) {}
+
+public:
+	void Start( const std::string& filename );
+	void Join()								{ m_job.Join(); }
+	void Reset();
+	void Cancel();
+
+	bool IsStarted() const					{ return m_job.IsStarted(); }
+	bool IsFinished() const					{ return m_job.IsFinished(); }
+	bool Succeeded() const					{ return m_job.Succeeded(); }
+	const std::string& GetFilename() const	{ return m_filename; }
+
+	MapData& GetData()						{ return *m_data; }
+	const MapData& GetData() const			{ return *m_data; }
+
+private:
+	std::string m_filename;
+	std::shared_ptr<MapData> m_data;	// Shared with the read, so a canceled one can finish into it
+	BackgroundJob m_job;				// Last, so it's joined before the data goes
+};
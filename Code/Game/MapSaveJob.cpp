@@ -0,0 +1,25 @@
+#include "Game/MapSaveJob.hpp"
+
+//--------------------------------------------------------------------------
+/**
+* Start
+* Saves are written in order; a new one waits for the last to finish.
+*/
+void MapSaveJob::Start( const std::string& filename, MapData&& data )
+{
+	Reset();
+	m_filename = filename;
+	m_data = std::move( data );
+	m_job.Start( [this]() { return WriteMapXml( m_filename.c_str(), m_data ); } );
+}
+
+//--------------------------------------------------------------------------
+/**
+* Reset
+*/
+void MapSaveJob::Reset()
+{
+	m_job.Reset();
+	m_filename.clear();
+	m_data = MapData();
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include "Game/BackgroundJob.hpp"
+#include "Game/MapFormat.hpp"
+#include <string>
+
+//--------------------------------------------------------------------------
+// Writes a snapshot of a map to xml on a worker thread.
+// Only the owner thread touches the job; poll IsFinished() then Join().
+// A save in flight is always allowed to finish.
+//--------------------------------------------------------------------------
+class MapSaveJob
+{
+public:
+	void Start( const std::string& filename, MapData&& data );
+	void Join()								{ m_job.Join(); }
+	void Reset();
+
+	bool IsStarted() const					{ return m_job.IsStarted(); }
+	bool IsFinished() const					{ return m_job.IsFinished(); }
+	bool IsRunning() const					{ return m_job.IsRunning(); }
+	bool Succeeded() const					{ return m_job.Succeeded(); }
+	const std::string& GetFilename() const	{ return m_filename; }
+	const MapData& GetData() const			{ return m_data; }
+
+private:
+	std::string m_filename;
+	MapData m_data;
+	BackgroundJob m_job;	// Last, so it's joined before the data goes
+};
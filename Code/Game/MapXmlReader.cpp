@@ -0,0 +1,206 @@
+#include "Game/MapXmlReader.hpp"
+#include <string.h>
+
+//--------------------------------------------------------------------------
+// Helper
+static bool IsXmlWhitespace( char c )
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+//--------------------------------------------------------------------------
+// Helper
+static bool IsXmlNameChar( char c )
+{
+	return !IsXmlWhitespace( c ) && c != '=' && c != '/' && c != '>' && c != '<' && c != '"' && c != '\'';
+}
+
+//--------------------------------------------------------------------------
+/**
+* Equals
+*/
+bool MapToken::Equals( char const* str ) const
+{
+	size_t length = strlen( str );
+	return length == GetLength() && memcmp( m_begin, str, length ) == 0;
+}
+
+//--------------------------------------------------------------------------
+/**
+* Equals
+*/
+bool MapToken::Equals( const MapToken& other ) const
+{
+	return other.GetLength() == GetLength() && memcmp( m_begin, other.m_begin, GetLength() ) == 0;
+}
+
+//--------------------------------------------------------------------------
+/**
+* MapXmlReader
+*/
+MapXmlReader::MapXmlReader( const char* text, size_t size )
+	: m_cursor( text )
+	, m_end( text + size )
+{
+}
+
+//--------------------------------------------------------------------------
+/**
+* NextTag
+*/
+bool MapXmlReader::NextTag()
+{
+	// Finish off the last tag if its attributes weren't all read
+	MapToken name;
+	MapToken value;
+	while( m_inTag && NextAttribute( name, value ) ) {}
+
+	while( !m_hasError )
+	{
+		while( m_cursor < m_end && *m_cursor != '<' )
+		{
+			++m_cursor;
+		}
+		if( m_end - m_cursor < 2 )
+		{
+			return false;
+		}
+		++m_cursor;
+
+		if( *m_cursor == '?' )
+		{
+			SkipPast( "?>" );
+			continue;
+		}
+		if( *m_cursor == '!' )
+		{
+			SkipPast( m_end - m_cursor >= 3 && m_cursor[1] == '-' && m_cursor[2] == '-' ? "-->" : ">" );
+			continue;
+		}
+
+		m_isEndTag = *m_cursor == '/';
+		if( m_isEndTag )
+		{
+			++m_cursor;
+		}
+		m_tagName = ReadName();
+		if( m_tagName.GetLength() == 0 )
+		{
+			m_hasError = true;
+			return false;
+		}
+
+		if( m_isEndTag )
+		{
+			m_inTag = false;
+			return SkipPast( ">" );
+		}
+		m_inTag = true;
+		return true;
+	}
+	return false;
+}
+
+//--------------------------------------------------------------------------
+/**
+* NextAttribute
+*/
+bool MapXmlReader::NextAttribute( MapToken& outName, MapToken& outValue )
+{
+	if( !m_inTag || m_hasError )
+	{
+		return false;
+	}
+
+	SkipWhitespace();
+	if( m_cursor >= m_end )
+	{
+		m_hasError = true;
+		return false;
+	}
+	if( *m_cursor == '/' || *m_cursor == '>' )
+	{
+		m_inTag = false;
+		SkipPast( ">" );
+		return false;
+	}
+
+	outName = ReadName();
+	SkipWhitespace();
+	if( outName.GetLength() == 0 || m_cursor >= m_end || *m_cursor != '=' )
+	{
+		m_hasError = true;
+		return false;
+	}
+	++m_cursor;
+	SkipWhitespace();
+	if( m_cursor >= m_end || ( *m_cursor != '"' && *m_cursor != '\'' ) )
+	{
+		m_hasError = true;
+		return false;
+	}
+
+	char quote = *m_cursor++;
+	outValue.m_begin = m_cursor;
+	while( m_cursor < m_end && *m_cursor != quote )
+	{
+		++m_cursor;
+	}
+	if( m_cursor >= m_end )
+	{
+		m_hasError = true;
+		return false;
+	}
+	outValue.m_end = m_cursor++;
+	return true;
+}
+
+//--------------------------------------------------------------------------
+/**
+* SkipWhitespace
+*/
+void MapXmlReader::SkipWhitespace()
+{
+	while( m_cursor < m_end && IsXmlWhitespace( *m_cursor ) )
+	{
+		++m_cursor;
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* SkipPast
+* Moves the cursor just past the next terminator; flags an error if there isn't one.
+*/
+bool MapXmlReader::SkipPast( char const* terminator )
+{
+	size_t length = strlen( terminator );
+	while( m_cursor + length <= m_end )
+	{
+		if( memcmp( m_cursor, terminator, length ) == 0 )
+		{
+			m_cursor += length;
+			return true;
+		}
+		++m_cursor;
+	}
+	m_cursor = m_end;
+	m_hasError = true;
+	return false;
+}
+
+//--------------------------------------------------------------------------
+/**
+* ReadName
+*/
+MapToken MapXmlReader::ReadName()
+{
+	MapToken name;
+	name.m_begin = m_cursor;
+	while( m_cursor < m_end && IsXmlNameChar( *m_cursor ) )
+	{
+		++m_cursor;
+	}
+	name.m_end = m_cursor;
+	return name;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <stddef.h>
+
+//--------------------------------------------------------------------------
+// Non-owning slice of the reader's input buffer.
+//--------------------------------------------------------------------------
+struct MapToken
+{
+	const char* m_begin = nullptr;
+	const char* m_end	= nullptr;
+
+	size_t GetLength() const { return (size_t) ( m_end - m_begin ); }
+	bool Equals( char const* str ) const;
+	bool Equals( const MapToken& other ) const;
+};
+
+//--------------------------------------------------------------------------
+// Forward-only pull reader for the flat xml used by .map files.
+// Nothing is allocated; names and values point back into the input.
+// Comments, declarations and element text are skipped. No entity decoding.
+//--------------------------------------------------------------------------
+class MapXmlReader
+{
+public:
+	MapXmlReader( const char* text, size_t size );
+
+public:
+	// Advances to the next start or end tag. False at the end of input or on bad input.
+	bool NextTag();
+	// Call after a start tag; false once the tag's attributes are used up.
+	bool NextAttribute( MapToken& outName, MapToken& outValue );
+
+	const MapToken& GetTagName() const	{ return m_tagName; }
+	bool IsEndTag() const				{ return m_isEndTag; }
+	bool HasError() const				{ return m_hasError; }
+
+private:
+	void SkipWhitespace();
+	bool SkipPast( char const* terminator );
+	MapToken ReadName();
+
+private:
+	const char* m_cursor	= nullptr;
+	const char* m_end		= nullptr;
+	MapToken m_tagName;
+	bool m_isEndTag			= false;
+	bool m_inTag			= false;
+	bool m_hasError			= false;
+};
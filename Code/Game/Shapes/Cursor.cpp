@@ -30,9 +30,10 @@ void Cursor::Update( float deltaTime )
 	m_trasform.m_position.x = worldCamPos.x;
 	m_trasform.m_position.y = worldCamPos.y;
 	m_trasform.m_position = Vec2::ClampBetween( m_trasform.m_position, Vec2( -SCREEN_WIDTH * 0.5f, -SCREEN_HEIGHT *0.5f ) * g_theGame->GetCurrentMap()->m_camScale + camPos, Vec2( SCREEN_WIDTH * 0.5f, SCREEN_HEIGHT *0.5f ) * g_theGame->GetCurrentMap()->m_camScale + camPos );
-	if( g_theGame->m_selectedShape )
+	Shape* selectedShape = g_theGame->GetSelectedShape();
+	if( selectedShape )
 	{
-		g_theGame->m_selectedShape->SetPosition( m_trasform.m_position );
+		selectedShape->SetPosition( m_trasform.m_position );
 	}
 }
 
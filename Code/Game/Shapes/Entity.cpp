@@ -1,6 +1,5 @@
 #include "Game/Shapes/Entity.hpp"
 #include "Game/GameCommon.hpp"
-#include "Engine/Core/Time/StopWatch.hpp"
 #include "Game/App.hpp"
 
 //--------------------------------------------------------------------------
@@ -11,8 +10,7 @@ Entity::Entity( eAlignment alignment )
 	: m_alignment( alignment )
 {
 	m_tint = Rgba( 1.0f, 1.0f, 1.0f );
-	m_preventInputTimer = new StopWatch( g_theApp->m_gameClock );
-	m_preventInputTimer->SetAndReset( 0.1f );
+	m_preventInputTimer = g_theApp->m_gameTimers->Create( 0.1 );
 }
 
 
@@ -22,6 +20,7 @@ Entity::Entity( eAlignment alignment )
 */
 Entity::~Entity()
 {
+	g_theApp->m_gameTimers->Destroy( m_preventInputTimer );
 }
 
 //--------------------------------------------------------------------------
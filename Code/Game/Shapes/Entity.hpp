@@ -1,8 +1,7 @@
 #pragma once
 #include "Engine/Math/Vec2.hpp"
 #include "Game/GameCommon.hpp"
-
-class StopWatch;
+#include "Game/TimerService.hpp"
 
 class Entity
 {
@@ -32,10 +31,10 @@ protected:
 	// Gameplay
 	eAlignment m_alignment = ALIGNMENT_NEUTRAL;
 	float m_health = 1.0;
-	float m_collisionDamage = 0.05f;
+	float m_collisionDamage = 3.0f;		// Per second of contact
 	float m_speed = 20.0f;
 
-	StopWatch* m_preventInputTimer = nullptr;
+	TimerHandle m_preventInputTimer;
 
 	Rgba m_tint;
 };
@@ -24,6 +24,33 @@ Pill::Pill( const Transform2D& spawnLoaction , ePhysicsSimulationType simType, e
 	m_rigidbody->SetMass( mass );
 	m_rigidbody->SetPhyMaterial( restitution, friction, drag, angularDrag );
 	m_radius = radius;
+
+	m_definition.m_position		= spawnLoaction.m_position;
+	m_definition.m_scale		= spawnLoaction.m_scale;
+	m_definition.m_rotation		= spawnLoaction.m_rotation;
+	m_definition.m_alignment	= alignment;
+	m_definition.m_radius		= radius;
+	m_definition.m_extents		= Vec2( width * .5f, height * .5f );
+	m_definition.m_bodyType		= simType == PHYSICS_SIM_DYNAMIC ? SHAPE_BODY_DYNAMIC : SHAPE_BODY_STATIC;
+	m_definition.m_mass			= mass;
+	m_definition.m_restitution	= restitution;
+	m_definition.m_friction		= friction;
+	m_definition.m_drag			= drag;
+	m_definition.m_angularDrag	= angularDrag;
+}
+
+//--------------------------------------------------------------------------
+/**
+* Pill
+*/
+Pill::Pill( const ShapeDefinition& definition )
+	: Pill( Transform2D( definition.m_position, definition.m_rotation, definition.m_scale ), GetPhysicsSimulationType( definition.m_bodyType ), definition.m_alignment
+		, definition.m_extents.x * 2.0f, definition.m_extents.y * 2.0f, definition.m_radius
+		, definition.m_mass, definition.m_restitution, definition.m_friction, definition.m_drag, definition.m_angularDrag )
+{
+	m_definition = definition;
+	m_rigidbody->SetAngularVelocity( definition.m_angularVelocity );
+	m_rigidbody->SetRestrictions( definition.m_xRestricted, definition.m_yRestricted, definition.m_rotRestricted );
 }
 
 //--------------------------------------------------------------------------
@@ -70,30 +97,15 @@ static void AddVertsForTrimmedLine2D( std::vector<Vertex_PCU>& addToVerts, const
 }
 
 //--------------------------------------------------------------------------
-/**
-* Render
-*/
-void Pill::Render() const
+// Helper
+static void AddVertsForPillCorners2D( std::vector<Vertex_PCU>& verts, const Vec2& BL, const Vec2& BR, const Vec2& TL, const Vec2& TR
+	, float radius, const Rgba& color, const Rgba& boarderColor )
 {
-	g_theRenderer->BindTextureView( 0, nullptr );
-
-	Rgba color = Lerp( m_color, m_dyingColor, RangeMapFloat( m_health, .5f, 1.0f, 1.0f, 0.0f ) );
-	Rgba boarderColor = DeterminColor();
-
-	std::vector<Vertex_PCU> verts;
-	const Pillbox2 pill =  ( (PillboxCollider2D*) m_collider )->GetWorldShape();
-
-	Vec2 BL = pill.m_obb.m_center - pill.m_obb.m_extents.x * pill.m_obb.GetRight() - pill.m_obb.GetUp() * pill.m_obb.m_extents.y;
-	Vec2 TR = pill.m_obb.m_center + pill.m_obb.m_extents.x * pill.m_obb.GetRight() + pill.m_obb.GetUp() * pill.m_obb.m_extents.y;
-	Vec2 TL = pill.m_obb.m_center + pill.m_obb.GetUp() * pill.m_obb.m_extents.y - pill.m_obb.GetRight() * pill.m_obb.m_extents.x;
-	Vec2 BR = pill.m_obb.m_center - pill.m_obb.GetUp() * pill.m_obb.m_extents.y + pill.m_obb.GetRight() * pill.m_obb.m_extents.x;
-
 	// Disc
 	if( BL == TL && BL == BR )
 	{
-		AddVertsForDisc2D( verts, BL, pill.m_radius, color, 12 );
-		AddVertsForRing2D( verts, BL, pill.m_radius, 0.05f, boarderColor, 16 );
-		g_theRenderer->DrawVertexArray( verts );
+		AddVertsForDisc2D( verts, BL, radius, color, 12 );
+		AddVertsForRing2D( verts, BL, radius, 0.05f, boarderColor, 16 );
 		return;
 	}
 
@@ -101,14 +113,13 @@ void Pill::Render() const
 	if( BL != TL && BL == BR )
 	{
 		Vec2 alongHeight = TR - BR;
-		alongHeight.SetLength( pill.m_radius );
+		alongHeight.SetLength( radius );
 		alongHeight.Rotate90Degrees();
-		AddVertsForTrimmedLine2D( verts, BL, TL, pill.m_radius * 2.0f, color );
+		AddVertsForTrimmedLine2D( verts, BL, TL, radius * 2.0f, color );
 		AddVertsForLine2D( verts, BR - alongHeight, TR - alongHeight, 0.1f, boarderColor );
 		AddVertsForLine2D( verts, TL + alongHeight, BL + alongHeight, 0.1f, boarderColor );
-		AddVertsForDisc2D( verts, BL, pill.m_radius, color, 12 );
-		AddVertsForDisc2D( verts, TL, pill.m_radius, color, 12 );
-		g_theRenderer->DrawVertexArray( verts );
+		AddVertsForDisc2D( verts, BL, radius, color, 12 );
+		AddVertsForDisc2D( verts, TL, radius, color, 12 );
 		return;
 	}
 
@@ -116,40 +127,79 @@ void Pill::Render() const
 	if( BL != BR && BL == TL )
 	{
 		Vec2 alongWidth = BR - BL;
-		alongWidth.SetLength( pill.m_radius );
+		alongWidth.SetLength( radius );
 		alongWidth.RotateMinus90Degrees();
-		AddVertsForTrimmedLine2D( verts, BL, BR, pill.m_radius * 2.0f, color );
+		AddVertsForTrimmedLine2D( verts, BL, BR, radius * 2.0f, color );
 		AddVertsForLine2D( verts, TR - alongWidth, TL - alongWidth, 0.1f, boarderColor );
 		AddVertsForLine2D( verts, BL + alongWidth, BR + alongWidth, 0.1f, boarderColor );
-		AddVertsForDisc2D( verts, BL, pill.m_radius, color, 12 );
-		AddVertsForDisc2D( verts, BR, pill.m_radius, color, 12 );
-		g_theRenderer->DrawVertexArray( verts );
+		AddVertsForDisc2D( verts, BL, radius, color, 12 );
+		AddVertsForDisc2D( verts, BR, radius, color, 12 );
 		return;
 	}
 
 
 	Vec2 alongHeight = TR - BR;
 	float thickness = alongHeight.GetLength();
-	alongHeight.SetLength( pill.m_radius );
+	alongHeight.SetLength( radius );
 	alongHeight.Rotate90Degrees();
-	AddVertsForTrimmedLine2D( verts, ( BL + TL ) * .5f, ( BR + TR ) * .5f, pill.m_radius * 2.0f + thickness, color );
+	AddVertsForTrimmedLine2D( verts, ( BL + TL ) * .5f, ( BR + TR ) * .5f, radius * 2.0f + thickness, color );
 	AddVertsForLine2D( verts, BR - alongHeight, TR - alongHeight, 0.1f, boarderColor );
 	AddVertsForLine2D( verts, TL + alongHeight, BL + alongHeight, 0.1f, boarderColor );
 
 	Vec2 alongWidth = BR - BL;
 	thickness = alongWidth.GetLength();
-	alongWidth.SetLength( pill.m_radius );
+	alongWidth.SetLength( radius );
 	alongWidth.RotateMinus90Degrees();
-	AddVertsForTrimmedLine2D( verts, ( BL + BR ) * .5f, ( TL + TR ) * .5f, pill.m_radius * 2.0f + thickness, color );
+	AddVertsForTrimmedLine2D( verts, ( BL + BR ) * .5f, ( TL + TR ) * .5f, radius * 2.0f + thickness, color );
 	AddVertsForLine2D( verts, TR - alongWidth, TL - alongWidth, 0.1f, boarderColor );
 	AddVertsForLine2D( verts, BL + alongWidth, BR + alongWidth, 0.1f, boarderColor );
 
-	AddVertsForDisc2D( verts, BL, pill.m_radius, color, 12 );
-	AddVertsForDisc2D( verts, BR, pill.m_radius, color, 12 );
-	AddVertsForDisc2D( verts, TR, pill.m_radius, color, 12 );
-	AddVertsForDisc2D( verts, TL, pill.m_radius, color, 12 );
+	AddVertsForDisc2D( verts, BL, radius, color, 12 );
+	AddVertsForDisc2D( verts, BR, radius, color, 12 );
+	AddVertsForDisc2D( verts, TR, radius, color, 12 );
+	AddVertsForDisc2D( verts, TL, radius, color, 12 );
+}
 
-	g_theRenderer->DrawVertexArray( verts );
+//--------------------------------------------------------------------------
+/**
+* AddVertsForPill2D
+*/
+void AddVertsForPill2D( std::vector<Vertex_PCU>& verts, const Pillbox2& pill, const Rgba& color, const Rgba& boarderColor )
+{
+	Vec2 BL = pill.m_obb.m_center - pill.m_obb.m_extents.x * pill.m_obb.GetRight() - pill.m_obb.GetUp() * pill.m_obb.m_extents.y;
+	Vec2 TR = pill.m_obb.m_center + pill.m_obb.m_extents.x * pill.m_obb.GetRight() + pill.m_obb.GetUp() * pill.m_obb.m_extents.y;
+	Vec2 TL = pill.m_obb.m_center + pill.m_obb.GetUp() * pill.m_obb.m_extents.y - pill.m_obb.GetRight() * pill.m_obb.m_extents.x;
+	Vec2 BR = pill.m_obb.m_center - pill.m_obb.GetUp() * pill.m_obb.m_extents.y + pill.m_obb.GetRight() * pill.m_obb.m_extents.x;
+	AddVertsForPillCorners2D( verts, BL, BR, TL, TR, pill.m_radius, color, boarderColor );
+}
+
+//--------------------------------------------------------------------------
+/**
+* AddVertsForPill2D
+* Draws the pill blend of the way from one state to the other. The axes are
+* blended and renormalized so a turning pill keeps its size.
+*/
+void AddVertsForPill2D( std::vector<Vertex_PCU>& verts, const Pillbox2& from, const Pillbox2& to, float blend, const Rgba& color, const Rgba& boarderColor )
+{
+	Vec2 center = Lerp( from.m_obb.m_center, to.m_obb.m_center, blend );
+	Vec2 extents = Lerp( from.m_obb.m_extents, to.m_obb.m_extents, blend );
+	float radius = Lerp( from.m_radius, to.m_radius, blend );
+	Vec2 right = Lerp( from.m_obb.GetRight(), to.m_obb.GetRight(), blend );
+	Vec2 up = Lerp( from.m_obb.GetUp(), to.m_obb.GetUp(), blend );
+	if( right.GetLengthSquared() < 0.0001f || up.GetLengthSquared() < 0.0001f )
+	{
+		// Half a turn in one step; nothing sensible between
+		right = to.m_obb.GetRight();
+		up = to.m_obb.GetUp();
+	}
+	right.Normalize();
+	up.Normalize();
+
+	Vec2 BL = center - extents.x * right - up * extents.y;
+	Vec2 TR = center + extents.x * right + up * extents.y;
+	Vec2 TL = center + up * extents.y - right * extents.x;
+	Vec2 BR = center - up * extents.y + right * extents.x;
+	AddVertsForPillCorners2D( verts, BL, BR, TL, TR, radius, color, boarderColor );
 }
 
 //--------------------------------------------------------------------------
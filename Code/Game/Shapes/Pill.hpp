@@ -1,5 +1,9 @@
 #pragma once
 #include "Game/Shapes/Shape.hpp"
+#include <vector>
+
+struct Vertex_PCU;
+struct Pillbox2;
 
 
 
@@ -10,14 +14,16 @@ public:
 	explicit Pill( const Transform2D& spawnLoaction, ePhysicsSimulationType simType, eAlignment alignment
 		, float width = 1.0f, float height = 1.0f, float radius = 1.0f
 		, float mass = 1.0f, float restitution = 1.0f, float friction = 0.0f, float drag = 0.0f, float angularDrag = 0.0f );
+	explicit Pill( const ShapeDefinition& definition );
 
 public:
-	void Render() const;
-
 	bool IsOutOfBounds( const AABB2& bounds ) const;
 
 private:
 	float m_width = 1.0f;
 	float m_height = 1.0f;
 	float m_radius = 1.0f;
-};
\ No newline at end of file
+};
+
+void AddVertsForPill2D( std::vector<Vertex_PCU>& verts, const Pillbox2& pill, const Rgba& color, const Rgba& boarderColor );
+void AddVertsForPill2D( std::vector<Vertex_PCU>& verts, const Pillbox2& from, const Pillbox2& to, float blend, const Rgba& color, const Rgba& boarderColor );
\ No newline at end of file
@@ -0,0 +1,150 @@
+#include "Game/Shapes/PillPool.hpp"
+
+//--------------------------------------------------------------------------
+/**
+* ~PillPool
+*/
+PillPool::~PillPool()
+{
+	ReleaseMemory();
+}
+
+//--------------------------------------------------------------------------
+/**
+* Destroy
+*/
+void PillPool::Destroy( Pill* pill )
+{
+	uint slotIdx = GetSlotIndex( pill );
+	ASSERT_OR_DIE( slotIdx != 0xFFFFFFFF && m_isLive[slotIdx], "Destroying a pill this pool doesn't own" );
+
+	pill->~Pill();
+	m_isLive[slotIdx] = false;
+	m_freeSlots.push_back( slotIdx );
+	--m_numLive;
+}
+
+//--------------------------------------------------------------------------
+/**
+* DestroyAll
+* Runs every live pill's destructor in memory order; keeps the blocks.
+*/
+void PillPool::DestroyAll()
+{
+	uint capacity = GetCapacity();
+	for( uint slotIdx = 0; slotIdx < capacity && m_numLive > 0; ++slotIdx )
+	{
+		if( m_isLive[slotIdx] )
+		{
+			( (Pill*) GetSlotMemory( slotIdx ) )->~Pill();
+			m_isLive[slotIdx] = false;
+			--m_numLive;
+		}
+	}
+	ResetFreeList();
+}
+
+//--------------------------------------------------------------------------
+/**
+* ReleaseMemory
+*/
+void PillPool::ReleaseMemory()
+{
+	DestroyAll();
+	for( unsigned char* block: m_blocks )
+	{
+		::operator delete( block );
+	}
+	m_blocks.clear();
+	m_freeSlots.clear();
+	m_isLive.clear();
+}
+
+//--------------------------------------------------------------------------
+/**
+* Reserve
+* Makes sure the next count Creates don't allocate.
+*/
+void PillPool::Reserve( uint count )
+{
+	while( (uint) m_freeSlots.size() < count )
+	{
+		AddBlock();
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* Owns
+*/
+bool PillPool::Owns( const Shape* shape ) const
+{
+	uint slotIdx = GetSlotIndex( shape );
+	return slotIdx != 0xFFFFFFFF && m_isLive[slotIdx];
+}
+
+//--------------------------------------------------------------------------
+/**
+* AllocateSlot
+*/
+uint PillPool::AllocateSlot()
+{
+	if( m_freeSlots.empty() )
+	{
+		AddBlock();
+	}
+
+	uint slotIdx = m_freeSlots.back();
+	m_freeSlots.pop_back();
+	m_isLive[slotIdx] = true;
+	++m_numLive;
+	return slotIdx;
+}
+
+//--------------------------------------------------------------------------
+/**
+* AddBlock
+* New slots go on top of the free list, lowest first.
+*/
+void PillPool::AddBlock()
+{
+	uint firstSlot = GetCapacity();
+	m_blocks.push_back( (unsigned char*) ::operator new( sizeof( Pill ) * PILLS_PER_BLOCK ) );
+	m_isLive.resize( GetCapacity(), false );
+	for( uint slotIdx = GetCapacity(); slotIdx > firstSlot; --slotIdx )
+	{
+		m_freeSlots.push_back( slotIdx - 1 );
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* ResetFreeList
+*/
+void PillPool::ResetFreeList()
+{
+	m_freeSlots.clear();
+	for( uint slotIdx = GetCapacity(); slotIdx > 0; --slotIdx )
+	{
+		m_freeSlots.push_back( slotIdx - 1 );
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* GetSlotIndex
+* 0xFFFFFFFF if the shape isn't in one of this pool's blocks.
+*/
+uint PillPool::GetSlotIndex( const Shape* shape ) const
+{
+	const unsigned char* address = (const unsigned char*) static_cast<const Pill*>( shape );
+	for( uint blockIdx = 0; blockIdx < (uint) m_blocks.size(); ++blockIdx )
+	{
+		const unsigned char* block = m_blocks[blockIdx];
+		if( address >= block && address < block + sizeof( Pill ) * PILLS_PER_BLOCK )
+		{
+			return blockIdx * PILLS_PER_BLOCK + (uint) ( address - block ) / (uint) sizeof( Pill );
+		}
+	}
+	return 0xFFFFFFFF;
+}
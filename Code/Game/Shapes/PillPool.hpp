@@ -0,0 +1,52 @@
+#pragma once
+#include "Engine/Core/EngineCommon.hpp"
+#include "Game/Shapes/Pill.hpp"
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+//--------------------------------------------------------------------------
+// Owns a map's Pills in fixed blocks so shapes spawned together sit next to
+// each other in memory. Freed slots are reused; DestroyAll keeps the blocks
+// so the next load refills them front to back without touching the heap.
+//--------------------------------------------------------------------------
+class PillPool
+{
+public:
+	PillPool() {}
+	PillPool( const PillPool& ) = delete;
+	PillPool& operator=( const PillPool& ) = delete;
+	~PillPool();
+
+	template <typename ...ARGS>
+	Pill* Create( ARGS&&... args )
+	{
+		uint slotIdx = AllocateSlot();
+		return new( GetSlotMemory( slotIdx ) ) Pill( std::forward<ARGS>( args )... );
+	}
+	void Destroy( Pill* pill );
+	void DestroyAll();
+	void ReleaseMemory();
+	void Reserve( uint count );
+
+	uint GetNumLive() const							{ return m_numLive; }
+	uint GetCapacity() const						{ return (uint) m_blocks.size() * PILLS_PER_BLOCK; }
+	bool Owns( const Shape* shape ) const;
+
+private:
+	uint AllocateSlot();
+	void AddBlock();
+	void ResetFreeList();
+	void* GetSlotMemory( uint slotIdx ) const		{ return m_blocks[slotIdx / PILLS_PER_BLOCK] + ( slotIdx % PILLS_PER_BLOCK ) * sizeof( Pill ); }
+	uint GetSlotIndex( const Shape* shape ) const;
+
+private:
+	static constexpr uint PILLS_PER_BLOCK = 256;
+	static_assert( alignof( Pill ) <= alignof( std::max_align_t ), "Pill needs more alignment than operator new gives" );
+
+	std::vector<unsigned char*> m_blocks;
+	std::vector<uint> m_freeSlots;		// Popped from the back; lowest slot last
+	std::vector<bool> m_isLive;
+	uint m_numLive = 0;
+};
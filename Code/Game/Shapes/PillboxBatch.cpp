@@ -0,0 +1,344 @@
+#include "Game/Shapes/PillboxBatch.hpp"
+#include "Engine/Physics/PillboxCollider2D.hpp"
+#include <algorithm>
+#include <math.h>
+#if defined( PILLBOX_BATCH_SSE )
+	#include <xmmintrin.h>
+#endif
+
+// Keeps degenerate edges (zero extents) from dividing by zero
+static const float MIN_EDGE_LENGTH_SQ = 1e-12f;
+
+//--------------------------------------------------------------------------
+/**
+* Add
+*/
+void PillboxLanes::Add( const Pillbox2& pill )
+{
+	Vec2 right = pill.m_obb.GetRight();
+	m_centerX.push_back( pill.m_obb.m_center.x );
+	m_centerY.push_back( pill.m_obb.m_center.y );
+	m_rightX.push_back( right.x );
+	m_rightY.push_back( right.y );
+	m_extentX.push_back( pill.m_obb.m_extents.x );
+	m_extentY.push_back( pill.m_obb.m_extents.y );
+	m_radius.push_back( pill.m_radius );
+}
+
+//--------------------------------------------------------------------------
+/**
+* Clear
+*/
+void PillboxLanes::Clear()
+{
+	m_centerX.clear();
+	m_centerY.clear();
+	m_rightX.clear();
+	m_rightY.clear();
+	m_extentX.clear();
+	m_extentY.clear();
+	m_radius.clear();
+}
+
+//--------------------------------------------------------------------------
+/**
+* Reserve
+*/
+void PillboxLanes::Reserve( uint count )
+{
+	m_centerX.reserve( count );
+	m_centerY.reserve( count );
+	m_rightX.reserve( count );
+	m_rightY.reserve( count );
+	m_extentX.reserve( count );
+	m_extentY.reserve( count );
+	m_radius.reserve( count );
+}
+
+//--------------------------------------------------------------------------
+/**
+* Add
+*/
+void PillboxPairBatch::Add( const Pillbox2& a, const Pillbox2& b )
+{
+	m_a.Add( a );
+	m_b.Add( b );
+}
+
+//--------------------------------------------------------------------------
+/**
+* Clear
+*/
+void PillboxPairBatch::Clear()
+{
+	m_a.Clear();
+	m_b.Clear();
+}
+
+//--------------------------------------------------------------------------
+/**
+* Reserve
+*/
+void PillboxPairBatch::Reserve( uint count )
+{
+	m_a.Reserve( count );
+	m_b.Reserve( count );
+}
+
+//--------------------------------------------------------------------------
+/**
+* ComputeSeparations
+* If the cores (the boxes without their rounding) don't intersect, the closest
+* points are a corner of one box and an edge of the other, so the core distance
+* is the least of the 32 corner to edge distances. Intersection is found by
+* separating axes first.
+*/
+void PillboxPairBatch::ComputeSeparations( float* out, bool allowSimd ) const
+{
+	uint begin = 0;
+#if defined( PILLBOX_BATCH_SSE )
+	if( allowSimd )
+	{
+		begin = ComputeSeparationsSSE( out );
+	}
+#else
+	UNUSED( allowSimd );
+#endif
+	ComputeSeparationsScalar( begin, GetCount(), out );
+}
+
+//--------------------------------------------------------------------------
+// Helper
+static void GetBoxCorners( float centerX, float centerY, float rightX, float rightY, float extentX, float extentY, float* outX, float* outY )
+{
+	float alongX = rightX * extentX;
+	float alongY = rightY * extentX;
+	float upX = -rightY * extentY;
+	float upY = rightX * extentY;
+	outX[0] = centerX - alongX - upX;	outY[0] = centerY - alongY - upY;
+	outX[1] = centerX + alongX - upX;	outY[1] = centerY + alongY - upY;
+	outX[2] = centerX + alongX + upX;	outY[2] = centerY + alongY + upY;
+	outX[3] = centerX - alongX + upX;	outY[3] = centerY - alongY + upY;
+}
+
+//--------------------------------------------------------------------------
+// Helper
+static float GetMinCornerToEdgeDistanceSq( const float* cornerX, const float* cornerY, const float* edgeX, const float* edgeY )
+{
+	float minDistSq = INFINITY;
+	for( int edgeIdx = 0; edgeIdx < 4; ++edgeIdx )
+	{
+		float startX = edgeX[edgeIdx];
+		float startY = edgeY[edgeIdx];
+		float dirX = edgeX[( edgeIdx + 1 ) & 3] - startX;
+		float dirY = edgeY[( edgeIdx + 1 ) & 3] - startY;
+		float invLengthSq = 1.0f / std::max( dirX * dirX + dirY * dirY, MIN_EDGE_LENGTH_SQ );
+		for( int cornerIdx = 0; cornerIdx < 4; ++cornerIdx )
+		{
+			float toX = cornerX[cornerIdx] - startX;
+			float toY = cornerY[cornerIdx] - startY;
+			float t = std::min( std::max( ( toX * dirX + toY * dirY ) * invLengthSq, 0.0f ), 1.0f );
+			float offX = toX - dirX * t;
+			float offY = toY - dirY * t;
+			minDistSq = std::min( minDistSq, offX * offX + offY * offY );
+		}
+	}
+	return minDistSq;
+}
+
+//--------------------------------------------------------------------------
+// Helper
+// Each pillbox is { centerX, centerY, rightX, rightY, extentX, extentY, radius }
+static float GetSeparationScalar( const float* a, const float* b )
+{
+	float axisX[4] = { a[2], -a[3], b[2], -b[3] };
+	float axisY[4] = { a[3], a[2], b[3], b[2] };
+	float dispX = b[0] - a[0];
+	float dispY = b[1] - a[1];
+	bool isSeparated = false;
+	for( int axisIdx = 0; axisIdx < 4; ++axisIdx )
+	{
+		float reachA = a[4] * fabsf( axisX[0] * axisX[axisIdx] + axisY[0] * axisY[axisIdx] )
+			+ a[5] * fabsf( axisX[1] * axisX[axisIdx] + axisY[1] * axisY[axisIdx] );
+		float reachB = b[4] * fabsf( axisX[2] * axisX[axisIdx] + axisY[2] * axisY[axisIdx] )
+			+ b[5] * fabsf( axisX[3] * axisX[axisIdx] + axisY[3] * axisY[axisIdx] );
+		isSeparated = isSeparated || fabsf( dispX * axisX[axisIdx] + dispY * axisY[axisIdx] ) > reachA + reachB;
+	}
+
+	float coreDistance = 0.0f;
+	if( isSeparated )
+	{
+		float cornersAX[4], cornersAY[4], cornersBX[4], cornersBY[4];
+		GetBoxCorners( a[0], a[1], a[2], a[3], a[4], a[5], cornersAX, cornersAY );
+		GetBoxCorners( b[0], b[1], b[2], b[3], b[4], b[5], cornersBX, cornersBY );
+		coreDistance = sqrtf( std::min( GetMinCornerToEdgeDistanceSq( cornersAX, cornersAY, cornersBX, cornersBY )
+			, GetMinCornerToEdgeDistanceSq( cornersBX, cornersBY, cornersAX, cornersAY ) ) );
+	}
+	return coreDistance - a[6] - b[6];
+}
+
+//--------------------------------------------------------------------------
+// Helper
+static void GetPillboxValues( const Pillbox2& pill, const PillboxPose& pose, float* out )
+{
+	out[0] = pose.m_center.x;
+	out[1] = pose.m_center.y;
+	out[2] = pose.m_right.x;
+	out[3] = pose.m_right.y;
+	out[4] = pill.m_obb.m_extents.x;
+	out[5] = pill.m_obb.m_extents.y;
+	out[6] = pill.m_radius;
+}
+
+//--------------------------------------------------------------------------
+// Helper
+static void GetLaneValues( const PillboxLanes& lanes, uint idx, float* out )
+{
+	out[0] = lanes.m_centerX[idx];
+	out[1] = lanes.m_centerY[idx];
+	out[2] = lanes.m_rightX[idx];
+	out[3] = lanes.m_rightY[idx];
+	out[4] = lanes.m_extentX[idx];
+	out[5] = lanes.m_extentY[idx];
+	out[6] = lanes.m_radius[idx];
+}
+
+//--------------------------------------------------------------------------
+/**
+* GetPillboxSeparation
+*/
+float GetPillboxSeparation( const Pillbox2& a, const Pillbox2& b )
+{
+	PillboxPose poseA = { a.m_obb.m_center, a.m_obb.GetRight() };
+	PillboxPose poseB = { b.m_obb.m_center, b.m_obb.GetRight() };
+	return GetPillboxSeparation( a, poseA, b, poseB );
+}
+
+//--------------------------------------------------------------------------
+/**
+* GetPillboxSeparation
+* With the pillboxes moved and turned to the given poses.
+*/
+float GetPillboxSeparation( const Pillbox2& a, const PillboxPose& poseA, const Pillbox2& b, const PillboxPose& poseB )
+{
+	float valuesA[7], valuesB[7];
+	GetPillboxValues( a, poseA, valuesA );
+	GetPillboxValues( b, poseB, valuesB );
+	return GetSeparationScalar( valuesA, valuesB );
+}
+
+//--------------------------------------------------------------------------
+/**
+* ComputeSeparationsScalar
+*/
+void PillboxPairBatch::ComputeSeparationsScalar( uint begin, uint end, float* out ) const
+{
+	float valuesA[7], valuesB[7];
+	for( uint pairIdx = begin; pairIdx < end; ++pairIdx )
+	{
+		GetLaneValues( m_a, pairIdx, valuesA );
+		GetLaneValues( m_b, pairIdx, valuesB );
+		out[pairIdx] = GetSeparationScalar( valuesA, valuesB );
+	}
+}
+
+#if defined( PILLBOX_BATCH_SSE )
+//--------------------------------------------------------------------------
+// Four pairs' worth of a 2D vector
+struct Vec2x4
+{
+	__m128 x;
+	__m128 y;
+};
+
+//--------------------------------------------------------------------------
+// Helper
+static inline __m128 AbsSSE( __m128 value )
+{
+	return _mm_andnot_ps( _mm_set1_ps( -0.0f ), value );
+}
+
+//--------------------------------------------------------------------------
+// Helper
+static inline __m128 DotSSE( const Vec2x4& a, const Vec2x4& b )
+{
+	return _mm_add_ps( _mm_mul_ps( a.x, b.x ), _mm_mul_ps( a.y, b.y ) );
+}
+
+//--------------------------------------------------------------------------
+// Helper
+static void GetBoxCornersSSE( const PillboxLanes& lanes, uint first, Vec2x4* outCorners, Vec2x4* outAxes, __m128* outExtents )
+{
+	Vec2x4 center	= { _mm_loadu_ps( &lanes.m_centerX[first] ), _mm_loadu_ps( &lanes.m_centerY[first] ) };
+	outAxes[0]		= { _mm_loadu_ps( &lanes.m_rightX[first] ), _mm_loadu_ps( &lanes.m_rightY[first] ) };
+	outAxes[1]		= { _mm_sub_ps( _mm_setzero_ps(), outAxes[0].y ), outAxes[0].x };
+	outExtents[0]	= _mm_loadu_ps( &lanes.m_extentX[first] );
+	outExtents[1]	= _mm_loadu_ps( &lanes.m_extentY[first] );
+
+	Vec2x4 along	= { _mm_mul_ps( outAxes[0].x, outExtents[0] ), _mm_mul_ps( outAxes[0].y, outExtents[0] ) };
+	Vec2x4 up		= { _mm_mul_ps( outAxes[1].x, outExtents[1] ), _mm_mul_ps( outAxes[1].y, outExtents[1] ) };
+	outCorners[0] = { _mm_sub_ps( _mm_sub_ps( center.x, along.x ), up.x ), _mm_sub_ps( _mm_sub_ps( center.y, along.y ), up.y ) };
+	outCorners[1] = { _mm_sub_ps( _mm_add_ps( center.x, along.x ), up.x ), _mm_sub_ps( _mm_add_ps( center.y, along.y ), up.y ) };
+	outCorners[2] = { _mm_add_ps( _mm_add_ps( center.x, along.x ), up.x ), _mm_add_ps( _mm_add_ps( center.y, along.y ), up.y ) };
+	outCorners[3] = { _mm_add_ps( _mm_sub_ps( center.x, along.x ), up.x ), _mm_add_ps( _mm_sub_ps( center.y, along.y ), up.y ) };
+}
+
+//--------------------------------------------------------------------------
+// Helper
+static __m128 GetMinCornerToEdgeDistanceSqSSE( const Vec2x4* corners, const Vec2x4* edges, __m128 minDistSq )
+{
+	__m128 zero = _mm_setzero_ps();
+	__m128 one = _mm_set1_ps( 1.0f );
+	for( int edgeIdx = 0; edgeIdx < 4; ++edgeIdx )
+	{
+		const Vec2x4& start = edges[edgeIdx];
+		Vec2x4 dir = { _mm_sub_ps( edges[( edgeIdx + 1 ) & 3].x, start.x ), _mm_sub_ps( edges[( edgeIdx + 1 ) & 3].y, start.y ) };
+		__m128 invLengthSq = _mm_div_ps( one, _mm_max_ps( DotSSE( dir, dir ), _mm_set1_ps( MIN_EDGE_LENGTH_SQ ) ) );
+		for( int cornerIdx = 0; cornerIdx < 4; ++cornerIdx )
+		{
+			Vec2x4 to = { _mm_sub_ps( corners[cornerIdx].x, start.x ), _mm_sub_ps( corners[cornerIdx].y, start.y ) };
+			__m128 t = _mm_min_ps( _mm_max_ps( _mm_mul_ps( DotSSE( to, dir ), invLengthSq ), zero ), one );
+			Vec2x4 off = { _mm_sub_ps( to.x, _mm_mul_ps( dir.x, t ) ), _mm_sub_ps( to.y, _mm_mul_ps( dir.y, t ) ) };
+			minDistSq = _mm_min_ps( minDistSq, DotSSE( off, off ) );
+		}
+	}
+	return minDistSq;
+}
+
+//--------------------------------------------------------------------------
+/**
+* ComputeSeparationsSSE
+* Same steps as the scalar path with a pair per lane. Returns how many pairs it covered.
+*/
+uint PillboxPairBatch::ComputeSeparationsSSE( float* out ) const
+{
+	uint numWide = GetCount() & ~3u;
+	for( uint first = 0; first < numWide; first += 4 )
+	{
+		Vec2x4 cornersA[4], cornersB[4];
+		Vec2x4 axes[4];		// A's right and up, then B's
+		__m128 extents[4];
+		GetBoxCornersSSE( m_a, first, cornersA, &axes[0], &extents[0] );
+		GetBoxCornersSSE( m_b, first, cornersB, &axes[2], &extents[2] );
+
+		Vec2x4 disp = { _mm_sub_ps( _mm_loadu_ps( &m_b.m_centerX[first] ), _mm_loadu_ps( &m_a.m_centerX[first] ) )
+			, _mm_sub_ps( _mm_loadu_ps( &m_b.m_centerY[first] ), _mm_loadu_ps( &m_a.m_centerY[first] ) ) };
+		__m128 isSeparated = _mm_setzero_ps();
+		for( int axisIdx = 0; axisIdx < 4; ++axisIdx )
+		{
+			__m128 reachA = _mm_add_ps( _mm_mul_ps( extents[0], AbsSSE( DotSSE( axes[0], axes[axisIdx] ) ) )
+				, _mm_mul_ps( extents[1], AbsSSE( DotSSE( axes[1], axes[axisIdx] ) ) ) );
+			__m128 reachB = _mm_add_ps( _mm_mul_ps( extents[2], AbsSSE( DotSSE( axes[2], axes[axisIdx] ) ) )
+				, _mm_mul_ps( extents[3], AbsSSE( DotSSE( axes[3], axes[axisIdx] ) ) ) );
+			isSeparated = _mm_or_ps( isSeparated, _mm_cmpgt_ps( AbsSSE( DotSSE( disp, axes[axisIdx] ) ), _mm_add_ps( reachA, reachB ) ) );
+		}
+
+		__m128 minDistSq = GetMinCornerToEdgeDistanceSqSSE( cornersA, cornersB, _mm_set1_ps( INFINITY ) );
+		minDistSq = GetMinCornerToEdgeDistanceSqSSE( cornersB, cornersA, minDistSq );
+		__m128 coreDistance = _mm_and_ps( isSeparated, _mm_sqrt_ps( minDistSq ) );
+		__m128 radii = _mm_add_ps( _mm_loadu_ps( &m_a.m_radius[first] ), _mm_loadu_ps( &m_b.m_radius[first] ) );
+		_mm_storeu_ps( &out[first], _mm_sub_ps( coreDistance, radii ) );
+	}
+	return numWide;
+}
+#endif
@@ -0,0 +1,72 @@
+#pragma once
+#include "Engine/Core/EngineCommon.hpp"
+#include "Engine/Math/Vec2.hpp"
+#include <vector>
+
+struct Pillbox2;
+
+//--------------------------------------------------------------------------
+// x64 always has SSE2; elsewhere only when the compiler says so
+#if defined( _M_X64 ) || defined( __SSE2__ ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+	#define PILLBOX_BATCH_SSE
+#endif
+
+//--------------------------------------------------------------------------
+// Where a pillbox is and which way it faces, apart from its dimensions
+struct PillboxPose
+{
+	Vec2 m_center;
+	Vec2 m_right;
+};
+
+//--------------------------------------------------------------------------
+// One pair on the scalar path; same result as a batch of one
+float GetPillboxSeparation( const Pillbox2& a, const Pillbox2& b );
+float GetPillboxSeparation( const Pillbox2& a, const PillboxPose& poseA, const Pillbox2& b, const PillboxPose& poseB );
+
+//--------------------------------------------------------------------------
+// Pillboxes in structure-of-arrays form. Only the right axis is kept; up is its
+// left-hand perpendicular.
+//--------------------------------------------------------------------------
+struct PillboxLanes
+{
+	void Add( const Pillbox2& pill );
+	void Clear();
+	void Reserve( uint count );
+
+	std::vector<float> m_centerX;
+	std::vector<float> m_centerY;
+	std::vector<float> m_rightX;
+	std::vector<float> m_rightY;
+	std::vector<float> m_extentX;
+	std::vector<float> m_extentY;
+	std::vector<float> m_radius;
+};
+
+//--------------------------------------------------------------------------
+// Pairs of pillboxes for the batched narrowphase. With SSE, four pairs are
+// tested per instruction; leftover pairs, or every pair without SSE, use the
+// scalar path, which runs the same math.
+//--------------------------------------------------------------------------
+class PillboxPairBatch
+{
+public:
+	void Add( const Pillbox2& a, const Pillbox2& b );
+	void Clear();
+	void Reserve( uint count );
+	uint GetCount() const							{ return (uint) m_a.m_radius.size(); }
+
+	// Distance between the pair's surfaces, out[pairIdx]; <= 0 when they overlap.
+	// Cores that intersect count as 0 apart, so this isn't a penetration depth.
+	void ComputeSeparations( float* out, bool allowSimd = true ) const;
+
+public:
+	PillboxLanes m_a;
+	PillboxLanes m_b;
+
+private:
+	void ComputeSeparationsScalar( uint begin, uint end, float* out ) const;
+#if defined( PILLBOX_BATCH_SSE )
+	uint ComputeSeparationsSSE( float* out ) const;
+#endif
+};
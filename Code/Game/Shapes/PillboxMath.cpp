@@ -0,0 +1,39 @@
+#include "Game/Shapes/PillboxMath.hpp"
+#include "Engine/Physics/PillboxCollider2D.hpp"
+#include <algorithm>
+#include <math.h>
+
+//--------------------------------------------------------------------------
+/**
+* GetDistanceToPillbox
+*/
+float GetDistanceToPillbox( const Pillbox2& pill, const Vec2& point )
+{
+	Vec2 right = pill.m_obb.GetRight();
+	Vec2 up = pill.m_obb.GetUp();
+	Vec2 disp = point - pill.m_obb.m_center;
+	float outsideX = std::max( fabsf( disp.x * right.x + disp.y * right.y ) - pill.m_obb.m_extents.x, 0.0f );
+	float outsideY = std::max( fabsf( disp.x * up.x + disp.y * up.y ) - pill.m_obb.m_extents.y, 0.0f );
+	return sqrtf( outsideX * outsideX + outsideY * outsideY ) - pill.m_radius;
+}
+
+//--------------------------------------------------------------------------
+/**
+* GetPillboxBoundRadius
+*/
+float GetPillboxBoundRadius( const Pillbox2& pill )
+{
+	return pill.m_obb.m_extents.GetLength() + pill.m_radius;
+}
+
+//--------------------------------------------------------------------------
+/**
+* GetPillboxHalfSize
+*/
+Vec2 GetPillboxHalfSize( const Pillbox2& pill )
+{
+	Vec2 right = pill.m_obb.GetRight();
+	Vec2 up = pill.m_obb.GetUp();
+	return Vec2( fabsf( right.x ) * pill.m_obb.m_extents.x + fabsf( up.x ) * pill.m_obb.m_extents.y + pill.m_radius
+		, fabsf( right.y ) * pill.m_obb.m_extents.x + fabsf( up.y ) * pill.m_obb.m_extents.y + pill.m_radius );
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include "Engine/Math/Vec2.hpp"
+
+struct Pillbox2;
+
+//--------------------------------------------------------------------------
+// Pillbox2 measurements shared by the map's queries and contact passes.
+//--------------------------------------------------------------------------
+float GetDistanceToPillbox( const Pillbox2& pill, const Vec2& point );	// Negative inside
+float GetPillboxBoundRadius( const Pillbox2& pill );
+Vec2 GetPillboxHalfSize( const Pillbox2& pill );						// Of the world aligned bounds
@@ -0,0 +1,123 @@
+#include "Game/Shapes/PillboxSweep.hpp"
+#include "Game/Shapes/PillboxMath.hpp"
+#include "Engine/Math/MathUtils.hpp"
+#include <math.h>
+
+// Gives up and reports a hit where it stands after this many advances
+static const int MAX_ADVANCES = 32;
+static const float NORMAL_PROBE = 0.001f;
+
+//--------------------------------------------------------------------------
+/**
+* Set
+*/
+void PillboxSweep::Set( const Pillbox2& start, const Pillbox2& end )
+{
+	m_end = end;
+	m_startCenter = start.m_obb.m_center;
+	m_startRight = start.m_obb.GetRight();
+	Vec2 endRight = end.m_obb.GetRight();
+	m_turn = atan2f( m_startRight.x * endRight.y - m_startRight.y * endRight.x, m_startRight.x * endRight.x + m_startRight.y * endRight.y );
+}
+
+//--------------------------------------------------------------------------
+/**
+* GetPose
+* t runs from 0 at the start of the step to 1 at the end.
+*/
+PillboxPose PillboxSweep::GetPose( float t ) const
+{
+	float angle = m_turn * t;
+	float cosAngle = cosf( angle );
+	float sinAngle = sinf( angle );
+	PillboxPose pose;
+	pose.m_center = Lerp( m_startCenter, m_end.m_obb.m_center, t );
+	pose.m_right = Vec2( m_startRight.x * cosAngle - m_startRight.y * sinAngle, m_startRight.x * sinAngle + m_startRight.y * cosAngle );
+	return pose;
+}
+
+//--------------------------------------------------------------------------
+/**
+* GetMotionBound
+*/
+float PillboxSweep::GetMotionBound() const
+{
+	return ( m_end.m_obb.m_center - m_startCenter ).GetLength() + fabsf( m_turn ) * GetPillboxBoundRadius( m_end );
+}
+
+//--------------------------------------------------------------------------
+/**
+* GetPointVelocity
+* Velocity of a point fixed to the pillbox at the end of the step.
+*/
+Vec2 PillboxSweep::GetPointVelocity( const Vec2& point, float stepSeconds ) const
+{
+	Vec2 arm = point - m_end.m_obb.m_center;
+	Vec2 linear = ( m_end.m_obb.m_center - m_startCenter ) * ( 1.0f / stepSeconds );
+	float angular = m_turn / stepSeconds;
+	return linear + Vec2( -arm.y * angular, arm.x * angular );
+}
+
+//--------------------------------------------------------------------------
+/**
+* FindPillboxTimeOfImpact
+*/
+bool FindPillboxTimeOfImpact( const PillboxSweep& a, const PillboxSweep& b, float slop, float& outT )
+{
+	Vec2 moveA = a.m_end.m_obb.m_center - a.m_startCenter;
+	Vec2 moveB = b.m_end.m_obb.m_center - b.m_startCenter;
+	float closingBound = ( moveB - moveA ).GetLength()
+		+ fabsf( a.m_turn ) * GetPillboxBoundRadius( a.m_end ) + fabsf( b.m_turn ) * GetPillboxBoundRadius( b.m_end );
+	if( closingBound <= 0.0f )
+	{
+		return false;
+	}
+
+	float t = 0.0f;
+	for( int advanceIdx = 0; advanceIdx < MAX_ADVANCES; ++advanceIdx )
+	{
+		float separation = GetPillboxSeparation( a.m_end, a.GetPose( t ), b.m_end, b.GetPose( t ) );
+		if( separation <= slop )
+		{
+			outT = t;
+			return true;
+		}
+		t += ( separation - slop * 0.5f ) / closingBound;
+		if( t > 1.0f )
+		{
+			return false;
+		}
+	}
+	outT = t;
+	return true;
+}
+
+//--------------------------------------------------------------------------
+/**
+* GetPillboxSeparationNormal
+* Central difference of the separation as b is nudged along each axis.
+*/
+Vec2 GetPillboxSeparationNormal( const Pillbox2& a, const PillboxPose& poseA, const Pillbox2& b, const PillboxPose& poseB )
+{
+	PillboxPose nudged = poseB;
+	Vec2 gradient;
+	nudged.m_center = poseB.m_center + Vec2( NORMAL_PROBE, 0.0f );
+	gradient.x = GetPillboxSeparation( a, poseA, b, nudged );
+	nudged.m_center = poseB.m_center - Vec2( NORMAL_PROBE, 0.0f );
+	gradient.x -= GetPillboxSeparation( a, poseA, b, nudged );
+	nudged.m_center = poseB.m_center + Vec2( 0.0f, NORMAL_PROBE );
+	gradient.y = GetPillboxSeparation( a, poseA, b, nudged );
+	nudged.m_center = poseB.m_center - Vec2( 0.0f, NORMAL_PROBE );
+	gradient.y -= GetPillboxSeparation( a, poseA, b, nudged );
+
+	if( gradient.GetLengthSquared() <= 0.0f )
+	{
+		gradient = poseB.m_center - poseA.m_center;
+	}
+	if( gradient.GetLengthSquared() <= 0.0f )
+	{
+		return Vec2::UP;
+	}
+	gradient.Normalize();
+	return gradient;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "Engine/Physics/PillboxCollider2D.hpp"
+#include "Game/Shapes/PillboxBatch.hpp"
+
+//--------------------------------------------------------------------------
+// A pillbox's motion over one physics step: a straight move between the two
+// centers while turning the short way between the two right axes.
+//--------------------------------------------------------------------------
+struct PillboxSweep
+{
+	void Set( const Pillbox2& start, const Pillbox2& end );
+	PillboxPose GetPose( float t ) const;
+	float GetMotionBound() const;				// Furthest any point of the pillbox travels
+	Vec2 GetPointVelocity( const Vec2& point, float stepSeconds ) const;
+
+	Pillbox2 m_end;
+	Vec2 m_startCenter	= Vec2::ZERO;
+	Vec2 m_startRight	= Vec2::RIGHT;
+	float m_turn		= 0.0f;					// Radians, counter-clockwise
+};
+
+//--------------------------------------------------------------------------
+// Conservative advancement: steps forward by the current gap over the fastest the
+// gap can close, so it can't step past a touch. False if the two stay more than
+// slop apart for the whole step.
+//--------------------------------------------------------------------------
+bool FindPillboxTimeOfImpact( const PillboxSweep& a, const PillboxSweep& b, float slop, float& outT );
+
+// Direction b would move to separate from a fastest; needs them apart
+Vec2 GetPillboxSeparationNormal( const Pillbox2& a, const PillboxPose& poseA, const Pillbox2& b, const PillboxPose& poseB );
@@ -7,6 +7,9 @@
 #include "Engine/Physics/Collider2D.hpp"
 #include "Engine/Physics/AABB2Collider2D.hpp"
 #include "Engine/Physics/DiscCollider2D.hpp"
+#include "Game/App.hpp"
+#include "Game/TimerService.hpp"
+#include "Game/Map.hpp"
 
 
 
@@ -47,6 +50,20 @@ void Shape::Update( float deltaSec )
 	UNUSED(deltaSec);
 }
 
+//--------------------------------------------------------------------------
+/**
+* Die
+* The owning map frees the shape at its next sync point.
+*/
+void Shape::Die()
+{
+	Entity::Die();
+	if( m_map )
+	{
+		m_map->QueueDestroy( m_handle );
+	}
+}
+
 //--------------------------------------------------------------------------
 /**
 * GetPosition
@@ -77,27 +94,74 @@ void Shape::SetPosition( const Vec2& pos )
 
 //--------------------------------------------------------------------------
 /**
-* DeterminColor
+* AddForce
+* Wakes the shape first if its map has put it to sleep.
 */
-Rgba Shape::DeterminColor() const
+void Shape::AddForce( const Vec2& force )
 {
-	if( m_selected )
+	if( m_map && force != Vec2::ZERO )
 	{
-		return Rgba::WHITE;
+		m_map->WakeShape( m_handle );
 	}
+	m_rigidbody->AddForce( force );
+}
+
+//--------------------------------------------------------------------------
+/**
+* ResetToDefinition
+* Reuses this shape and its rigidbody; collider dimensions are assumed unchanged.
+*/
+void Shape::ResetToDefinition( const ShapeDefinition& definition )
+{
+	m_definition = definition;
+	m_transform = Transform2D( definition.m_position, definition.m_rotation, definition.m_scale );
+
+	m_alignment = definition.m_alignment;
+	m_health = 1.0f;
+	m_isDead = false;
+	m_isGarbage = false;
+	g_theApp->m_gameTimers->Reset( m_preventInputTimer );
+
+	m_rigidbody->SetOriginalSimulationType( GetPhysicsSimulationType( definition.m_bodyType ) );
+	m_rigidbody->ResetSimulationType();
+	m_rigidbody->SetMass( definition.m_mass );
+	m_rigidbody->SetPhyMaterial( definition.m_restitution, definition.m_friction, definition.m_drag, definition.m_angularDrag );
+	m_rigidbody->SetVelocity( Vec2::ZERO );
+	m_rigidbody->SetAngularVelocity( definition.m_angularVelocity );
+	m_rigidbody->SetRestrictions( definition.m_xRestricted, definition.m_yRestricted, definition.m_rotRestricted );
+}
+
+//--------------------------------------------------------------------------
+/**
+* GetFillColor
+* Fades toward the dying color as health drops.
+*/
+Rgba Shape::GetFillColor() const
+{
+	return Lerp( m_color, m_dyingColor, RangeMapFloat( m_health, .5f, 1.0f, 1.0f, 0.0f ) );
+}
+
+//--------------------------------------------------------------------------
+/**
+* DeterminColor
+* Border color, given whether the map has the shape touching anything; the map
+* draws selected shapes white instead.
+*/
+Rgba Shape::DeterminColor( bool isTouching ) const
+{
 	Rgba color = Rgba::CYAN;
 	
 	{
 		switch( m_rigidbody->GetSimulationType() )
 		{
 		case ePhysicsSimulationType::PHYSICS_SIM_DYNAMIC:
-			if( m_collider->IsColliding() )
+			if( isTouching )
 				color = m_boarderColor;
 			else
 				color = m_hitColor;
 			break;
 		case ePhysicsSimulationType::PHYSICS_SIM_STATIC:
-			if( m_collider->IsColliding() )
+			if( isTouching )
 				color = m_boarderColor;
 			else
 				color = m_hitColor;
@@ -3,8 +3,11 @@
 #include "Engine/Physics/PhysicsSystem.hpp"
 #include "Engine/Physics/Rigidbody2D.hpp"
 #include "Game/Shapes/Entity.hpp"
+#include "Game/Shapes/ShapeDefinition.hpp"
+#include "Game/Shapes/ShapeSlotMap.hpp"
 
 class Collider2D;
+class Map;
 class Rigidbody2D;
 
 
@@ -15,16 +18,19 @@ public:
 	explicit Shape( const Transform2D& spawnLoaction, ePhysicsSimulationType simType, eAlignment alignment );
 	~Shape();
 
-	virtual void Render() const = 0;
 	virtual void Update( float deltaSec );
+	virtual void Die();
 	virtual bool IsOutOfBounds( const AABB2& bounds ) const = 0;
 	Vec2 GetPosition() const;
 	void SetTransform( Transform2D trasform );
 	void SetPosition( const Vec2& pos );
+	void AddForce( const Vec2& force );
+	void ResetToDefinition( const ShapeDefinition& definition );
+	Rgba GetFillColor() const;
+	Rgba DeterminColor( bool isTouching ) const;
 
 
 protected:
-	Rgba DeterminColor() const;
 	Rgba m_color = Rgba::BLUE;
 	Rgba m_dyingColor = Rgba::DARK_RED;
 	Rgba m_boarderColor = Rgba::BLACK;
@@ -34,7 +40,10 @@ public:
 	Rigidbody2D* m_rigidbody;
 	Collider2D* m_collider;
 	Transform2D m_transform;
-	bool m_selected = false;
-	bool m_isGarbage = false;
+	ShapeDefinition m_definition;
+	ShapeHandle m_handle;	// Set by the owning map
+	Map* m_map = nullptr;	// Set by the owning map
+	int m_pristineIdx = -1;	// Index into the owning map's pristine snapshot, -1 if not from the map file
+	int m_regionIdx = -1;	// Map region that streams this shape in and out, -1 if never streamed
 };
 
@@ -0,0 +1,105 @@
+#include "Game/Shapes/ShapeBroadphase.hpp"
+#include "Game/Shapes/Shape.hpp"
+#include "Game/Shapes/ShapeTables.hpp"
+#include "Game/Shapes/PillboxMath.hpp"
+#include <algorithm>
+
+//--------------------------------------------------------------------------
+/**
+* Update
+* Refreshes the bounds of every shape still alive, restores the order with an
+* insertion sort (cheap while shapes move a little per frame), merges in shapes
+* added since the last update, then sweeps for pairs.
+*/
+void ShapeBroadphase::Update( const ShapeSlotMap& shapes, const ShapeTables& tables )
+{
+	uint numRows = tables.GetCount();
+	m_rowSeen.assign( numRows, false );
+
+	uint numKept = 0;
+	for( const Entry& oldEntry: m_entries )
+	{
+		uint rowIdx = shapes.GetDenseIndex( oldEntry.m_handle );
+		if( rowIdx == shapes.GetCount() )
+		{
+			continue;
+		}
+		Entry& entry = m_entries[numKept++];
+		entry = oldEntry;
+		entry.m_row = rowIdx;
+		FillEntry( entry, tables );
+		m_rowSeen[rowIdx] = true;
+	}
+	m_entries.resize( numKept );
+
+	m_numSwaps = 0;
+	for( uint entryIdx = 1; entryIdx < numKept; ++entryIdx )
+	{
+		Entry entry = m_entries[entryIdx];
+		uint slotIdx = entryIdx;
+		for( ; slotIdx > 0 && IsLess( entry, m_entries[slotIdx - 1] ); --slotIdx )
+		{
+			m_entries[slotIdx] = m_entries[slotIdx - 1];
+		}
+		m_entries[slotIdx] = entry;
+		m_numSwaps += entryIdx - slotIdx;
+	}
+
+	for( uint rowIdx = 0; rowIdx < numRows; ++rowIdx )
+	{
+		if( !m_rowSeen[rowIdx] )
+		{
+			Entry entry;
+			entry.m_handle = shapes[rowIdx]->m_handle;
+			entry.m_row = rowIdx;
+			FillEntry( entry, tables );
+			m_entries.push_back( entry );
+		}
+	}
+	if( m_entries.size() > numKept )
+	{
+		std::sort( m_entries.begin() + numKept, m_entries.end(), IsLess );
+		std::inplace_merge( m_entries.begin(), m_entries.begin() + numKept, m_entries.end(), IsLess );
+	}
+
+	m_candidates.clear();
+	uint numEntries = (uint) m_entries.size();
+	for( uint entryIdx = 0; entryIdx < numEntries; ++entryIdx )
+	{
+		const Entry& a = m_entries[entryIdx];
+		for( uint otherIdx = entryIdx + 1; otherIdx < numEntries && m_entries[otherIdx].m_minX <= a.m_maxX; ++otherIdx )
+		{
+			const Entry& b = m_entries[otherIdx];
+			if( ( a.m_isDynamic || b.m_isDynamic ) && a.m_minY <= b.m_maxY && b.m_minY <= a.m_maxY )
+			{
+				m_candidates.push_back( { a.m_handle, b.m_handle, a.m_row, b.m_row } );
+			}
+		}
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* Clear
+*/
+void ShapeBroadphase::Clear()
+{
+	m_entries.clear();
+	m_candidates.clear();
+	m_numSwaps = 0;
+}
+
+//--------------------------------------------------------------------------
+/**
+* FillEntry
+*/
+void ShapeBroadphase::FillEntry( Entry& entry, const ShapeTables& tables )
+{
+	const Pillbox2& pill = tables.m_worldShapes[entry.m_row];
+	Vec2 halfSize = GetPillboxHalfSize( pill );
+	entry.m_minX = pill.m_obb.m_center.x - halfSize.x;
+	entry.m_maxX = pill.m_obb.m_center.x + halfSize.x;
+	entry.m_minY = pill.m_obb.m_center.y - halfSize.y;
+	entry.m_maxY = pill.m_obb.m_center.y + halfSize.y;
+	entry.m_isDynamic = tables.HasFlag( entry.m_row, SHAPE_FLAG_DYNAMIC );
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "Game/Shapes/ShapeSlotMap.hpp"
+#include <vector>
+
+class ShapeTables;
+
+//--------------------------------------------------------------------------
+// Two shapes whose world bounds overlap. Rows are only good until the tables next change.
+//--------------------------------------------------------------------------
+struct ShapePair
+{
+	ShapeHandle m_a;
+	ShapeHandle m_b;
+	uint m_rowA;
+	uint m_rowB;
+};
+
+//--------------------------------------------------------------------------
+// Incremental sweep and prune on the x axis. Bounds are kept sorted across
+// frames, so a frame where little moved costs close to a linear pass. Pairs of
+// two static shapes are never reported.
+//--------------------------------------------------------------------------
+class ShapeBroadphase
+{
+public:
+	void Update( const ShapeSlotMap& shapes, const ShapeTables& tables );
+	void Clear();
+
+	const std::vector<ShapePair>& GetCandidates() const	{ return m_candidates; }
+	uint GetNumSwaps() const						{ return m_numSwaps; }
+
+private:
+	struct Entry
+	{
+		float m_minX;
+		float m_maxX;
+		float m_minY;
+		float m_maxY;
+		ShapeHandle m_handle;
+		uint m_row;
+		bool m_isDynamic;
+	};
+
+	static void FillEntry( Entry& entry, const ShapeTables& tables );
+	static bool IsLess( const Entry& a, const Entry& b )	{ return a.m_minX < b.m_minX; }
+
+private:
+	std::vector<Entry> m_entries;		// Ascending min x
+	std::vector<ShapePair> m_candidates;
+	std::vector<bool> m_rowSeen;
+	uint m_numSwaps = 0;				// Insertion sort moves last update; how much order changed
+};
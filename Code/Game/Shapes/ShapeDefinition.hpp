@@ -0,0 +1,48 @@
+#pragma once
+#include "Engine/Math/Vec2.hpp"
+#include "Engine/Physics/Rigidbody2D.hpp"
+#include "Game/GameUtils.hpp"
+
+//--------------------------------------------------------------------------
+// Kinematic bodies are static to physics. Their map turns them at their angular
+// velocity and they push dynamic bodies without being pushed back.
+//--------------------------------------------------------------------------
+enum eShapeBodyType
+{
+	SHAPE_BODY_STATIC,
+	SHAPE_BODY_DYNAMIC,
+	SHAPE_BODY_KINEMATIC,
+};
+
+inline ePhysicsSimulationType GetPhysicsSimulationType( eShapeBodyType bodyType )	{ return bodyType == SHAPE_BODY_DYNAMIC ? PHYSICS_SIM_DYNAMIC : PHYSICS_SIM_STATIC; }
+
+//--------------------------------------------------------------------------
+// Everything needed to build a Shape - what a <shape> element in a map describes.
+//--------------------------------------------------------------------------
+struct ShapeDefinition
+{
+	// Trans
+	Vec2 m_position			= Vec2::ZERO;
+	Vec2 m_scale			= Vec2::ZERO;
+	float m_rotation		= 0.0f;
+	eAlignment m_alignment	= ALIGNMENT_NEUTRAL;
+
+	// Collider
+	float m_radius			= 1.0f;
+	Vec2 m_extents			= Vec2::ONE;
+	Vec2 m_localCenter		= Vec2::ZERO;
+	Vec2 m_localRight		= Vec2::RIGHT;
+
+	// Rigidbody
+	eShapeBodyType m_bodyType = SHAPE_BODY_STATIC;
+	float m_mass			= 1.0f;
+	float m_restitution		= 0.0f;
+	float m_friction		= 0.2f;
+	float m_drag			= 0.5f;
+	float m_angularDrag		= 0.0f;
+	float m_angularVelocity = 0.5f;
+	bool m_xRestricted		= false;
+	bool m_yRestricted		= false;
+	bool m_rotRestricted	= false;
+	bool m_continuous		= false;	// Swept against its neighbours every physics step
+};
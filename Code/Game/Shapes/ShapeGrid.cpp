@@ -0,0 +1,239 @@
+#include "Game/Shapes/ShapeGrid.hpp"
+#include <algorithm>
+#include <math.h>
+#include <stdlib.h>
+
+//--------------------------------------------------------------------------
+const uint64_t ShapeGrid::NO_CELL;
+
+//--------------------------------------------------------------------------
+// Helper
+static uint64_t MakeCellKey( int cellX, int cellY )
+{
+	return ( (uint64_t) (uint32_t) cellX << 32 ) | (uint64_t) (uint32_t) cellY;
+}
+
+//--------------------------------------------------------------------------
+/**
+* ShapeGrid
+*/
+ShapeGrid::ShapeGrid( float cellSize )
+	: m_cellSize( cellSize )
+{
+}
+
+//--------------------------------------------------------------------------
+/**
+* GetCellKey
+*/
+uint64_t ShapeGrid::GetCellKey( const Vec2& point ) const
+{
+	return MakeCellKey( GetCellCoord( point.x ), GetCellCoord( point.y ) );
+}
+
+//--------------------------------------------------------------------------
+/**
+* Move
+* fromKey may be NO_CELL for a shape that isn't in the grid yet.
+*/
+void ShapeGrid::Move( ShapeHandle handle, uint64_t fromKey, uint64_t toKey )
+{
+	if( fromKey == toKey )
+	{
+		return;
+	}
+	if( fromKey != NO_CELL )
+	{
+		Remove( handle, fromKey );
+	}
+
+	m_cells[toKey].push_back( handle );
+	GrowBounds( toKey );
+}
+
+//--------------------------------------------------------------------------
+/**
+* InsertBatch
+* Files shapes that aren't in the grid yet, one hash lookup per distinct cell.
+*/
+void ShapeGrid::InsertBatch( const std::vector<ShapeHandle>& handles, const std::vector<uint64_t>& cellKeys )
+{
+	uint count = (uint) handles.size();
+	m_batchOrder.resize( count );
+	for( uint entryIdx = 0; entryIdx < count; ++entryIdx )
+	{
+		m_batchOrder[entryIdx] = entryIdx;
+	}
+	std::sort( m_batchOrder.begin(), m_batchOrder.end(), [&]( uint a, uint b ) { return cellKeys[a] < cellKeys[b]; } );
+
+	uint runStart = 0;
+	while( runStart < count )
+	{
+		uint64_t cellKey = cellKeys[m_batchOrder[runStart]];
+		uint runEnd = runStart + 1;
+		while( runEnd < count && cellKeys[m_batchOrder[runEnd]] == cellKey )
+		{
+			++runEnd;
+		}
+
+		std::vector<ShapeHandle>& cell = m_cells[cellKey];
+		cell.reserve( cell.size() + ( runEnd - runStart ) );
+		for( uint orderIdx = runStart; orderIdx < runEnd; ++orderIdx )
+		{
+			cell.push_back( handles[m_batchOrder[orderIdx]] );
+		}
+		GrowBounds( cellKey );
+		runStart = runEnd;
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* Remove
+*/
+void ShapeGrid::Remove( ShapeHandle handle, uint64_t cellKey )
+{
+	auto found = m_cells.find( cellKey );
+	if( found == m_cells.end() )
+	{
+		return;
+	}
+	std::vector<ShapeHandle>& cell = found->second;
+	for( uint entryIdx = 0; entryIdx < (uint) cell.size(); ++entryIdx )
+	{
+		if( cell[entryIdx] == handle )
+		{
+			cell[entryIdx] = cell.back();
+			cell.pop_back();
+			break;
+		}
+	}
+	if( cell.empty() )
+	{
+		m_cells.erase( found );
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* Clear
+*/
+void ShapeGrid::Clear()
+{
+	m_cells.clear();
+	m_minCellX = 0;
+	m_minCellY = 0;
+	m_maxCellX = -1;
+	m_maxCellY = -1;
+}
+
+//--------------------------------------------------------------------------
+/**
+* GatherBox
+* Appends every handle in a cell the box touches.
+*/
+void ShapeGrid::GatherBox( const Vec2& mins, const Vec2& maxs, std::vector<ShapeHandle>& out ) const
+{
+	int minX = std::max( GetCellCoord( mins.x ), m_minCellX );
+	int minY = std::max( GetCellCoord( mins.y ), m_minCellY );
+	int maxX = std::min( GetCellCoord( maxs.x ), m_maxCellX );
+	int maxY = std::min( GetCellCoord( maxs.y ), m_maxCellY );
+	for( int cellY = minY; cellY <= maxY; ++cellY )
+	{
+		for( int cellX = minX; cellX <= maxX; ++cellX )
+		{
+			GatherCell( cellX, cellY, out );
+		}
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* GatherRing
+* Appends the handles in the square ring of cells ring steps out from the point's cell.
+*/
+void ShapeGrid::GatherRing( const Vec2& point, int ring, std::vector<ShapeHandle>& out ) const
+{
+	int centerX = GetCellCoord( point.x );
+	int centerY = GetCellCoord( point.y );
+	if( ring == 0 )
+	{
+		GatherCell( centerX, centerY, out );
+		return;
+	}
+	for( int offset = -ring; offset <= ring; ++offset )
+	{
+		GatherCell( centerX + offset, centerY - ring, out );
+		GatherCell( centerX + offset, centerY + ring, out );
+	}
+	for( int offset = -ring + 1; offset <= ring - 1; ++offset )
+	{
+		GatherCell( centerX - ring, centerY + offset, out );
+		GatherCell( centerX + ring, centerY + offset, out );
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* GetMaxRing
+* Rings past this one around the point hold no cells; -1 if the grid is empty.
+*/
+int ShapeGrid::GetMaxRing( const Vec2& point ) const
+{
+	if( m_cells.empty() )
+	{
+		return -1;
+	}
+	int centerX = GetCellCoord( point.x );
+	int centerY = GetCellCoord( point.y );
+	int ringX = std::max( std::abs( centerX - m_minCellX ), std::abs( m_maxCellX - centerX ) );
+	int ringY = std::max( std::abs( centerY - m_minCellY ), std::abs( m_maxCellY - centerY ) );
+	return std::max( ringX, ringY );
+}
+
+//--------------------------------------------------------------------------
+/**
+* GetCellCoord
+*/
+int ShapeGrid::GetCellCoord( float value ) const
+{
+	// Clamped so unbounded query boxes don't overflow
+	float cell = floorf( value / m_cellSize );
+	return (int) std::max( -1.0e9f, std::min( cell, 1.0e9f ) );
+}
+
+//--------------------------------------------------------------------------
+/**
+* GrowBounds
+*/
+void ShapeGrid::GrowBounds( uint64_t cellKey )
+{
+	int cellX = (int) (uint32_t) ( cellKey >> 32 );
+	int cellY = (int) (uint32_t) cellKey;
+	if( m_maxCellX < m_minCellX )
+	{
+		m_minCellX = m_maxCellX = cellX;
+		m_minCellY = m_maxCellY = cellY;
+	}
+	m_minCellX = std::min( m_minCellX, cellX );
+	m_minCellY = std::min( m_minCellY, cellY );
+	m_maxCellX = std::max( m_maxCellX, cellX );
+	m_maxCellY = std::max( m_maxCellY, cellY );
+}
+
+//--------------------------------------------------------------------------
+/**
+* GatherCell
+*/
+void ShapeGrid::GatherCell( int cellX, int cellY, std::vector<ShapeHandle>& out ) const
+{
+	if( cellX < m_minCellX || cellX > m_maxCellX || cellY < m_minCellY || cellY > m_maxCellY )
+	{
+		return;
+	}
+	auto found = m_cells.find( MakeCellKey( cellX, cellY ) );
+	if( found != m_cells.end() )
+	{
+		out.insert( out.end(), found->second.begin(), found->second.end() );
+	}
+}
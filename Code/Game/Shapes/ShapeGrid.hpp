@@ -0,0 +1,50 @@
+#pragma once
+#include "Engine/Math/Vec2.hpp"
+#include "Game/Shapes/ShapeSlotMap.hpp"
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+//--------------------------------------------------------------------------
+// Uniform hash grid of shape handles, bucketed by shape center. Shapes sit
+// in exactly one cell, so box queries must be grown by the largest shape's
+// bounding radius to catch shapes that hang over a cell edge.
+//--------------------------------------------------------------------------
+class ShapeGrid
+{
+public:
+	explicit ShapeGrid( float cellSize = 4.0f );
+
+	uint64_t GetCellKey( const Vec2& point ) const;
+	void Move( ShapeHandle handle, uint64_t fromKey, uint64_t toKey );
+	void InsertBatch( const std::vector<ShapeHandle>& handles, const std::vector<uint64_t>& cellKeys );
+	void Remove( ShapeHandle handle, uint64_t cellKey );
+	void Clear();
+
+	void GatherBox( const Vec2& mins, const Vec2& maxs, std::vector<ShapeHandle>& out ) const;
+	void GatherRing( const Vec2& point, int ring, std::vector<ShapeHandle>& out ) const;
+	int GetMaxRing( const Vec2& point ) const;
+
+	float GetCellSize() const						{ return m_cellSize; }
+	bool IsEmpty() const							{ return m_cells.empty(); }
+
+public:
+	static const uint64_t NO_CELL = 0xFFFFFFFFFFFFFFFFull;
+
+private:
+	int GetCellCoord( float value ) const;
+	void GrowBounds( uint64_t cellKey );
+	void GatherCell( int cellX, int cellY, std::vector<ShapeHandle>& out ) const;
+
+private:
+	float m_cellSize;
+	std::unordered_map<uint64_t, std::vector<ShapeHandle>> m_cells;
+
+	// Every cell ever filled since the last Clear lies inside these
+	int m_minCellX = 0;
+	int m_minCellY = 0;
+	int m_maxCellX = -1;
+	int m_maxCellY = -1;
+
+	std::vector<uint> m_batchOrder;
+};
@@ -0,0 +1,122 @@
+#include "Game/Shapes/ShapeSlotMap.hpp"
+
+//--------------------------------------------------------------------------
+const ShapeHandle ShapeHandle::INVALID;
+
+// Shared by every slot map so a handle can never resolve in the wrong map
+static uint s_nextGeneration = 1;
+
+//--------------------------------------------------------------------------
+/**
+* Add
+*/
+ShapeHandle ShapeSlotMap::Add( Shape* shape )
+{
+	uint slotIdx = m_freeHead;
+	if( slotIdx != ShapeHandle::INVALID.m_slot )
+	{
+		m_freeHead = m_slots[slotIdx].m_denseIdx;
+	}
+	else
+	{
+		slotIdx = (uint) m_slots.size();
+		m_slots.emplace_back();
+	}
+
+	Slot& slot = m_slots[slotIdx];
+	slot.m_denseIdx = (uint) m_dense.size();
+	slot.m_generation = s_nextGeneration++;
+	if( s_nextGeneration == 0 )
+	{
+		s_nextGeneration = 1;
+	}
+	m_dense.push_back( shape );
+	m_denseToSlot.push_back( slotIdx );
+
+	ShapeHandle handle;
+	handle.m_slot = slotIdx;
+	handle.m_generation = slot.m_generation;
+	return handle;
+}
+
+//--------------------------------------------------------------------------
+/**
+* Remove
+* Returns the shape that was removed, nullptr if the handle was stale.
+*/
+Shape* ShapeSlotMap::Remove( ShapeHandle handle )
+{
+	Shape* shape = Get( handle );
+	if( !shape )
+	{
+		return nullptr;
+	}
+
+	Slot& slot = m_slots[handle.m_slot];
+	uint lastIdx = (uint) m_dense.size() - 1;
+	if( slot.m_denseIdx != lastIdx )
+	{
+		m_dense[slot.m_denseIdx] = m_dense[lastIdx];
+		m_denseToSlot[slot.m_denseIdx] = m_denseToSlot[lastIdx];
+		m_slots[m_denseToSlot[lastIdx]].m_denseIdx = slot.m_denseIdx;
+	}
+	m_dense.pop_back();
+	m_denseToSlot.pop_back();
+
+	slot.m_generation = 0;
+	slot.m_denseIdx = m_freeHead;
+	m_freeHead = handle.m_slot;
+	return shape;
+}
+
+//--------------------------------------------------------------------------
+/**
+* Get
+*/
+Shape* ShapeSlotMap::Get( ShapeHandle handle ) const
+{
+	if( handle.m_slot >= (uint) m_slots.size() || handle.m_generation == 0 )
+	{
+		return nullptr;
+	}
+	const Slot& slot = m_slots[handle.m_slot];
+	return slot.m_generation == handle.m_generation ? m_dense[slot.m_denseIdx] : nullptr;
+}
+
+//--------------------------------------------------------------------------
+/**
+* GetDenseIndex
+* Position of the shape in iteration order, GetCount() if the handle is stale.
+*/
+uint ShapeSlotMap::GetDenseIndex( ShapeHandle handle ) const
+{
+	if( !Get( handle ) )
+	{
+		return GetCount();
+	}
+	return m_slots[handle.m_slot].m_denseIdx;
+}
+
+//--------------------------------------------------------------------------
+/**
+* Clear
+* Every outstanding handle goes stale.
+*/
+void ShapeSlotMap::Clear()
+{
+	m_slots.clear();
+	m_dense.clear();
+	m_denseToSlot.clear();
+	m_freeHead = ShapeHandle::INVALID.m_slot;
+}
+
+//--------------------------------------------------------------------------
+/**
+* Reserve
+*/
+void ShapeSlotMap::Reserve( uint count )
+{
+	m_slots.reserve( count );
+	m_dense.reserve( count );
+	m_denseToSlot.reserve( count );
+}
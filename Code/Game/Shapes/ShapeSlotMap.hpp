@@ -0,0 +1,56 @@
+#pragma once
+#include "Engine/Core/EngineCommon.hpp"
+#include <vector>
+
+class Shape;
+
+//--------------------------------------------------------------------------
+// Weak reference to a Shape in a ShapeSlotMap. Goes stale once the shape is
+// removed, even if its slot is reused. Generations are unique across maps.
+//--------------------------------------------------------------------------
+struct ShapeHandle
+{
+	uint m_slot			= 0xFFFFFFFF;
+	uint m_generation	= 0;
+
+	bool IsSet() const								{ return m_generation != 0; }
+	bool operator==( const ShapeHandle& other ) const	{ return m_slot == other.m_slot && m_generation == other.m_generation; }
+	bool operator!=( const ShapeHandle& other ) const	{ return !( *this == other ); }
+
+	static const ShapeHandle INVALID;
+};
+
+//--------------------------------------------------------------------------
+// O(1) add, remove and lookup; live shapes are packed in a dense array for iteration.
+// Removing swaps the last shape into the hole, so iterate backwards when removing in a loop.
+// Doesn't own the shapes.
+//--------------------------------------------------------------------------
+class ShapeSlotMap
+{
+public:
+	ShapeHandle Add( Shape* shape );
+	Shape* Remove( ShapeHandle handle );
+	Shape* Get( ShapeHandle handle ) const;
+	void Clear();
+	void Reserve( uint count );
+
+	uint GetCount() const							{ return (uint) m_dense.size(); }
+	bool IsEmpty() const							{ return m_dense.empty(); }
+	Shape* operator[]( uint denseIdx ) const		{ return m_dense[denseIdx]; }
+	uint GetDenseIndex( ShapeHandle handle ) const;
+
+	std::vector<Shape*>::const_iterator begin() const	{ return m_dense.begin(); }
+	std::vector<Shape*>::const_iterator end() const		{ return m_dense.end(); }
+
+private:
+	struct Slot
+	{
+		uint m_denseIdx		= 0;	// Next free slot while the slot is unused
+		uint m_generation	= 0;	// 0 while unused
+	};
+
+	std::vector<Slot> m_slots;
+	std::vector<Shape*> m_dense;
+	std::vector<uint> m_denseToSlot;
+	uint m_freeHead = 0xFFFFFFFF;
+};
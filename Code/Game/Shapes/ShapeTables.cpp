@@ -0,0 +1,167 @@
+#include "Game/Shapes/ShapeTables.hpp"
+#include "Game/Shapes/ShapeGrid.hpp"
+#include <utility>
+
+//--------------------------------------------------------------------------
+// No real center compares equal to this, so a fresh row is always tested
+static const Vec2 UNTESTED_POS = Vec2( 3.4028235e38f, 3.4028235e38f );
+
+//--------------------------------------------------------------------------
+/**
+* Add
+* Appends a row with no flags set; returns its index.
+*/
+uint ShapeTables::Add()
+{
+	m_worldShapes.emplace_back();
+	m_prevWorldShapes.emplace_back();
+	m_fillColors.push_back( Rgba::BLUE );
+	m_borderColors.push_back( Rgba::BLACK );
+	m_flags.push_back( 0 );
+	m_gridCells.push_back( ShapeGrid::NO_CELL );
+	m_triggerTestPos.push_back( UNTESTED_POS );
+	m_triggerContacts.emplace_back();
+	m_restSeconds.push_back( 0.0f );
+	m_kinematicSpins.emplace_back();
+	m_prevVelocities.push_back( Vec2::ZERO );
+	m_numContacts.push_back( 0 );
+	m_activeSlots.push_back( NO_ACTIVE_SLOT );
+	return GetCount() - 1;
+}
+
+//--------------------------------------------------------------------------
+/**
+* SwapRemove
+* Moves the last row into rowIdx, matching ShapeSlotMap::Remove.
+*/
+void ShapeTables::SwapRemove( uint rowIdx )
+{
+	SetActive( rowIdx, false );
+	uint lastIdx = GetCount() - 1;
+	if( rowIdx != lastIdx )
+	{
+		m_worldShapes[rowIdx]	= m_worldShapes[lastIdx];
+		m_prevWorldShapes[rowIdx]	= m_prevWorldShapes[lastIdx];
+		m_fillColors[rowIdx]	= m_fillColors[lastIdx];
+		m_borderColors[rowIdx]	= m_borderColors[lastIdx];
+		m_flags[rowIdx]			= m_flags[lastIdx];
+		m_gridCells[rowIdx]		= m_gridCells[lastIdx];
+		m_triggerTestPos[rowIdx]	= m_triggerTestPos[lastIdx];
+		std::swap( m_triggerContacts[rowIdx], m_triggerContacts[lastIdx] );
+		m_restSeconds[rowIdx]	= m_restSeconds[lastIdx];
+		m_kinematicSpins[rowIdx]	= m_kinematicSpins[lastIdx];
+		m_prevVelocities[rowIdx]	= m_prevVelocities[lastIdx];
+		m_numContacts[rowIdx]	= m_numContacts[lastIdx];
+		m_activeSlots[rowIdx]	= m_activeSlots[lastIdx];
+		if( m_activeSlots[rowIdx] != NO_ACTIVE_SLOT )
+		{
+			m_activeRows[m_activeSlots[rowIdx]] = rowIdx;
+		}
+	}
+	m_worldShapes.pop_back();
+	m_prevWorldShapes.pop_back();
+	m_fillColors.pop_back();
+	m_borderColors.pop_back();
+	m_flags.pop_back();
+	m_gridCells.pop_back();
+	m_triggerTestPos.pop_back();
+	m_triggerContacts.pop_back();
+	m_restSeconds.pop_back();
+	m_kinematicSpins.pop_back();
+	m_prevVelocities.pop_back();
+	m_numContacts.pop_back();
+	m_activeSlots.pop_back();
+}
+
+//--------------------------------------------------------------------------
+/**
+* Clear
+*/
+void ShapeTables::Clear()
+{
+	m_worldShapes.clear();
+	m_prevWorldShapes.clear();
+	m_fillColors.clear();
+	m_borderColors.clear();
+	m_flags.clear();
+	m_gridCells.clear();
+	m_triggerTestPos.clear();
+	m_triggerContacts.clear();
+	m_restSeconds.clear();
+	m_kinematicSpins.clear();
+	m_prevVelocities.clear();
+	m_numContacts.clear();
+	m_activeRows.clear();
+	m_activeSlots.clear();
+}
+
+//--------------------------------------------------------------------------
+/**
+* Reserve
+*/
+void ShapeTables::Reserve( uint count )
+{
+	m_worldShapes.reserve( count );
+	m_prevWorldShapes.reserve( count );
+	m_fillColors.reserve( count );
+	m_borderColors.reserve( count );
+	m_flags.reserve( count );
+	m_gridCells.reserve( count );
+	m_triggerTestPos.reserve( count );
+	m_triggerContacts.reserve( count );
+	m_restSeconds.reserve( count );
+	m_kinematicSpins.reserve( count );
+	m_prevVelocities.reserve( count );
+	m_numContacts.reserve( count );
+	m_activeSlots.reserve( count );
+}
+
+//--------------------------------------------------------------------------
+/**
+* SetFlag
+*/
+void ShapeTables::SetFlag( uint rowIdx, eShapeFlag flag, bool isSet )
+{
+	if( isSet )
+	{
+		m_flags[rowIdx] |= flag;
+	}
+	else
+	{
+		m_flags[rowIdx] &= (uint8_t) ~flag;
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* SetActive
+* Adds the row to m_activeRows or swap-removes it from there.
+*/
+void ShapeTables::SetActive( uint rowIdx, bool isActive )
+{
+	uint slotIdx = m_activeSlots[rowIdx];
+	if( isActive && slotIdx == NO_ACTIVE_SLOT )
+	{
+		m_activeSlots[rowIdx] = (uint) m_activeRows.size();
+		m_activeRows.push_back( rowIdx );
+	}
+	else if( !isActive && slotIdx != NO_ACTIVE_SLOT )
+	{
+		uint movedRow = m_activeRows.back();
+		m_activeRows[slotIdx] = movedRow;
+		m_activeSlots[movedRow] = slotIdx;
+		m_activeRows.pop_back();
+		m_activeSlots[rowIdx] = NO_ACTIVE_SLOT;
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* ResetTriggerState
+* Forgets the row's triggers; it is retested, and gets enter events again, next frame.
+*/
+void ShapeTables::ResetTriggerState( uint rowIdx )
+{
+	m_triggerTestPos[rowIdx] = UNTESTED_POS;
+	m_triggerContacts[rowIdx].clear();
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include "Game/GameCommon.hpp"
+#include "Engine/Physics/PillboxCollider2D.hpp"
+#include <math.h>
+#include <stdint.h>
+#include <vector>
+
+//--------------------------------------------------------------------------
+enum eShapeFlag : uint8_t
+{
+	SHAPE_FLAG_SELECTED		= 1 << 0,
+	SHAPE_FLAG_GARBAGE		= 1 << 1,	// Queued for destruction
+	SHAPE_FLAG_DYNAMIC		= 1 << 2,	// Simulated by physics as of the last gather
+	SHAPE_FLAG_CONTINUOUS	= 1 << 3,	// Swept against its neighbours every physics step
+	SHAPE_FLAG_ASLEEP		= 1 << 4,	// Parked as static until something wakes it
+	SHAPE_FLAG_KINEMATIC	= 1 << 5,	// Turned by the map, not by physics
+	SHAPE_FLAG_TOUCHING		= 1 << 6,	// In at least one contact as of the last contact events
+};
+
+//--------------------------------------------------------------------------
+// A kinematic body's rotation is worked out from when its rate last changed, so
+// it doesn't drift however long it spins.
+//--------------------------------------------------------------------------
+struct KinematicSpin
+{
+	double m_baseTime		= 0.0;		// Map physics seconds
+	float m_baseRotation	= 0.0f;		// Degrees
+	float m_rate			= 0.0f;		// Degrees per second
+	float m_lastRotation	= NAN;		// Last written; anything else means the rotation was set from outside
+};
+
+//--------------------------------------------------------------------------
+// Per-frame shape state in structure-of-arrays form, one row per live shape
+// in the same order as the owning ShapeSlotMap's dense array. Rows must be
+// added and swap-removed alongside the slot map.
+//--------------------------------------------------------------------------
+class ShapeTables
+{
+public:
+	uint Add();
+	void SwapRemove( uint rowIdx );
+	void Clear();
+	void Reserve( uint count );
+
+	uint GetCount() const							{ return (uint) m_flags.size(); }
+	bool HasFlag( uint rowIdx, eShapeFlag flag ) const	{ return ( m_flags[rowIdx] & flag ) != 0; }
+	void SetFlag( uint rowIdx, eShapeFlag flag, bool isSet );
+	void ResetTriggerState( uint rowIdx );
+	void SnapPreviousState( uint rowIdx )			{ m_prevWorldShapes[rowIdx] = m_worldShapes[rowIdx]; }
+	bool IsActive( uint rowIdx ) const				{ return m_activeSlots[rowIdx] != NO_ACTIVE_SLOT; }
+	void SetActive( uint rowIdx, bool isActive );
+
+public:
+	static const uint NO_ACTIVE_SLOT = 0xFFFFFFFF;
+
+public:
+	// Gathered from the physics side once a frame
+	std::vector<Pillbox2> m_worldShapes;
+	std::vector<Pillbox2> m_prevWorldShapes;	// From before the frame's last physics step; rendering blends from here
+	std::vector<Rgba> m_fillColors;
+	std::vector<Rgba> m_borderColors;
+
+	// Owned here; set by the game and editor
+	std::vector<uint8_t> m_flags;
+
+	// ShapeGrid cell the shape is filed under
+	std::vector<uint64_t> m_gridCells;
+
+	// Center when triggers were last tested, and the triggers it was inside, ascending
+	std::vector<Vec2> m_triggerTestPos;
+	std::vector<std::vector<uint>> m_triggerContacts;
+
+	// Physics seconds spent below the sleep speeds; 0 while moving
+	std::vector<float> m_restSeconds;
+
+	// Velocity at the start of the current physics step, for contact impulses
+	std::vector<Vec2> m_prevVelocities;
+
+	// Contacts begun and not yet ended
+	std::vector<uint16_t> m_numContacts;
+
+	// Only meaningful for kinematic rows
+	std::vector<KinematicSpin> m_kinematicSpins;
+
+	// Dynamic and kinematic rows that aren't asleep, in no particular order, and
+	// each row's index into it. Kept by SetActive and SwapRemove
+	std::vector<uint> m_activeRows;
+	std::vector<uint> m_activeSlots;
+};
@@ -0,0 +1,140 @@
+#include "Game/TimerService.hpp"
+#include <limits>
+
+//--------------------------------------------------------------------------
+const TimerHandle TimerHandle::INVALID;
+
+static const double NEVER = std::numeric_limits<double>::infinity();
+static uint s_nextGeneration = 1;
+
+//--------------------------------------------------------------------------
+/**
+* Create
+* Starts counting down immediately.
+*/
+TimerHandle TimerService::Create( double duration )
+{
+	uint slotIdx;
+	if( !m_freeSlots.empty() )
+	{
+		slotIdx = m_freeSlots.back();
+		m_freeSlots.pop_back();
+	}
+	else
+	{
+		slotIdx = (uint) m_deadlines.size();
+		m_deadlines.push_back( NEVER );
+		m_durations.push_back( 0.0 );
+		m_generations.push_back( 0 );
+		m_elapsed.push_back( false );
+	}
+
+	m_generations[slotIdx] = s_nextGeneration++;
+	if( s_nextGeneration == 0 )
+	{
+		s_nextGeneration = 1;
+	}
+	++m_numTimers;
+
+	TimerHandle handle;
+	handle.m_slot = slotIdx;
+	handle.m_generation = m_generations[slotIdx];
+	SetAndReset( handle, duration );
+	return handle;
+}
+
+//--------------------------------------------------------------------------
+/**
+* Destroy
+* Frees the slot and clears the handle.
+*/
+void TimerService::Destroy( TimerHandle& handle )
+{
+	if( IsValid( handle ) )
+	{
+		m_deadlines[handle.m_slot] = NEVER;
+		m_generations[handle.m_slot] = 0;
+		m_elapsed[handle.m_slot] = false;
+		m_freeSlots.push_back( handle.m_slot );
+		--m_numTimers;
+	}
+	handle = TimerHandle::INVALID;
+}
+
+//--------------------------------------------------------------------------
+/**
+* Reset
+* Restarts the countdown with the timer's current duration.
+*/
+void TimerService::Reset( TimerHandle handle )
+{
+	if( IsValid( handle ) )
+	{
+		SetAndReset( handle, m_durations[handle.m_slot] );
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* SetAndReset
+*/
+void TimerService::SetAndReset( TimerHandle handle, double duration )
+{
+	if( !IsValid( handle ) )
+	{
+		return;
+	}
+	m_durations[handle.m_slot] = duration;
+	m_deadlines[handle.m_slot] = m_time + duration;
+	m_elapsed[handle.m_slot] = duration <= 0.0;
+}
+
+//--------------------------------------------------------------------------
+/**
+* HasElapsed
+* As of the last Update. A stale handle counts as elapsed.
+*/
+bool TimerService::HasElapsed( TimerHandle handle ) const
+{
+	return !IsValid( handle ) || m_elapsed[handle.m_slot];
+}
+
+//--------------------------------------------------------------------------
+/**
+* GetRemainingTime
+*/
+double TimerService::GetRemainingTime( TimerHandle handle ) const
+{
+	if( HasElapsed( handle ) )
+	{
+		return 0.0;
+	}
+	return m_deadlines[handle.m_slot] - m_time;
+}
+
+//--------------------------------------------------------------------------
+/**
+* Update
+*/
+void TimerService::Update( double deltaSeconds )
+{
+	m_time += deltaSeconds;
+	uint numSlots = (uint) m_deadlines.size();
+	for( uint slotIdx = 0; slotIdx < numSlots; ++slotIdx )
+	{
+		if( m_deadlines[slotIdx] <= m_time )
+		{
+			m_elapsed[slotIdx] = true;
+			m_deadlines[slotIdx] = NEVER;
+		}
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* IsValid
+*/
+bool TimerService::IsValid( TimerHandle handle ) const
+{
+	return handle.m_slot < (uint) m_generations.size() && handle.IsSet() && m_generations[handle.m_slot] == handle.m_generation;
+}
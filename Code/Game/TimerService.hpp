@@ -0,0 +1,52 @@
+#pragma once
+#include "Engine/Core/EngineCommon.hpp"
+#include <vector>
+
+//--------------------------------------------------------------------------
+// Weak reference to a timer in a TimerService.
+//--------------------------------------------------------------------------
+struct TimerHandle
+{
+	uint m_slot			= 0xFFFFFFFF;
+	uint m_generation	= 0;
+
+	bool IsSet() const								{ return m_generation != 0; }
+
+	static const TimerHandle INVALID;
+};
+
+//--------------------------------------------------------------------------
+// Countdown timers on one clock, kept in flat arrays. Update advances the
+// service's time and flags every expired timer in a single pass, so
+// HasElapsed is a lookup rather than a clock query per object.
+//--------------------------------------------------------------------------
+class TimerService
+{
+public:
+	TimerHandle Create( double duration );
+	void Destroy( TimerHandle& handle );
+	void Reset( TimerHandle handle );
+	void SetAndReset( TimerHandle handle, double duration );
+	bool HasElapsed( TimerHandle handle ) const;
+	double GetRemainingTime( TimerHandle handle ) const;
+
+	void Update( double deltaSeconds );
+
+	double GetTime() const							{ return m_time; }
+	uint GetNumTimers() const						{ return m_numTimers; }
+	uint GetCapacity() const						{ return (uint) m_deadlines.size(); }
+
+private:
+	bool IsValid( TimerHandle handle ) const;
+
+private:
+	double m_time = 0.0;
+
+	// Parallel, indexed by slot. Free slots have an infinite deadline so Update never flags them
+	std::vector<double> m_deadlines;
+	std::vector<double> m_durations;
+	std::vector<uint> m_generations;	// 0 while the slot is free
+	std::vector<bool> m_elapsed;
+	std::vector<uint> m_freeSlots;
+	uint m_numTimers = 0;
+};
@@ -0,0 +1,26 @@
+#pragma once
+#include "Engine/Math/Vec2.hpp"
+#include <stdint.h>
+
+//--------------------------------------------------------------------------
+enum eTriggerType : uint8_t
+{
+	TRIGGER_END_ZONE,		// Player finishes the level
+	TRIGGER_CHECKPOINT,		// Player respawns here
+	TRIGGER_DAMAGE,			// m_value damage per second while inside
+	TRIGGER_SPEED,			// Velocity scaled by m_value on entering
+	TRIGGER_KILL,
+
+	NUM_TRIGGER_TYPES
+};
+
+//--------------------------------------------------------------------------
+// Circle a shape's center can enter and leave, as declared in the map file.
+//--------------------------------------------------------------------------
+struct TriggerDefinition
+{
+	eTriggerType m_type		= TRIGGER_CHECKPOINT;
+	Vec2 m_center			= Vec2::ZERO;
+	float m_radius			= 1.0f;
+	float m_value			= 0.0f;
+};
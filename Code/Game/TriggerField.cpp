@@ -0,0 +1,145 @@
+#include "Game/TriggerField.hpp"
+#include <algorithm>
+#include <math.h>
+
+//--------------------------------------------------------------------------
+// Triggers covering more cells than this go on the oversized list instead
+constexpr int64_t MAX_CELLS_PER_TRIGGER = 1024;
+
+//--------------------------------------------------------------------------
+// Helper
+static uint64_t MakeCellKey( int cellX, int cellY )
+{
+	return ( (uint64_t) (uint32_t) cellX << 32 ) | (uint64_t) (uint32_t) cellY;
+}
+
+//--------------------------------------------------------------------------
+/**
+* TriggerField
+*/
+TriggerField::TriggerField( float cellSize )
+	: m_cellSize( cellSize )
+{
+}
+
+//--------------------------------------------------------------------------
+/**
+* Build
+* Replaces the field's triggers; indices match the order given.
+*/
+void TriggerField::Build( const TriggerDefinition* triggers, uint count )
+{
+	Clear();
+	m_triggers.assign( triggers, triggers + count );
+	for( uint triggerIdx = 0; triggerIdx < count; ++triggerIdx )
+	{
+		const TriggerDefinition& trigger = m_triggers[triggerIdx];
+		int minX = GetCellCoord( trigger.m_center.x - trigger.m_radius );
+		int minY = GetCellCoord( trigger.m_center.y - trigger.m_radius );
+		int maxX = GetCellCoord( trigger.m_center.x + trigger.m_radius );
+		int maxY = GetCellCoord( trigger.m_center.y + trigger.m_radius );
+		if( (int64_t) ( maxX - minX + 1 ) * (int64_t) ( maxY - minY + 1 ) > MAX_CELLS_PER_TRIGGER )
+		{
+			m_oversized.push_back( triggerIdx );
+			continue;
+		}
+		for( int cellY = minY; cellY <= maxY; ++cellY )
+		{
+			for( int cellX = minX; cellX <= maxX; ++cellX )
+			{
+				// Filled in index order, so every cell list stays sorted
+				m_cells[MakeCellKey( cellX, cellY )].push_back( triggerIdx );
+			}
+		}
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* Clear
+*/
+void TriggerField::Clear()
+{
+	m_triggers.clear();
+	m_cells.clear();
+	m_oversized.clear();
+}
+
+//--------------------------------------------------------------------------
+/**
+* GatherAt
+* Appends every trigger containing the point, in ascending index order.
+*/
+void TriggerField::GatherAt( const Vec2& point, std::vector<uint>& out ) const
+{
+	size_t firstOut = out.size();
+	auto found = m_cells.find( MakeCellKey( GetCellCoord( point.x ), GetCellCoord( point.y ) ) );
+	if( found != m_cells.end() )
+	{
+		for( uint triggerIdx: found->second )
+		{
+			const TriggerDefinition& trigger = m_triggers[triggerIdx];
+			if( ( point - trigger.m_center ).GetLengthSquared() < trigger.m_radius * trigger.m_radius )
+			{
+				out.push_back( triggerIdx );
+			}
+		}
+	}
+
+	size_t firstOversized = out.size();
+	for( uint triggerIdx: m_oversized )
+	{
+		const TriggerDefinition& trigger = m_triggers[triggerIdx];
+		if( ( point - trigger.m_center ).GetLengthSquared() < trigger.m_radius * trigger.m_radius )
+		{
+			out.push_back( triggerIdx );
+		}
+	}
+	if( firstOversized != out.size() )
+	{
+		std::inplace_merge( out.begin() + firstOut, out.begin() + firstOversized, out.end() );
+	}
+}
+
+//--------------------------------------------------------------------------
+/**
+* GatherBox
+* Appends every trigger filed in a cell the box touches and every oversized one, each once, in ascending index order.
+*/
+void TriggerField::GatherBox( const Vec2& mins, const Vec2& maxs, std::vector<uint>& out ) const
+{
+	size_t firstOut = out.size();
+	int minX = GetCellCoord( mins.x );
+	int minY = GetCellCoord( mins.y );
+	int maxX = GetCellCoord( maxs.x );
+	int maxY = GetCellCoord( maxs.y );
+	for( int cellY = minY; cellY <= maxY; ++cellY )
+	{
+		for( int cellX = minX; cellX <= maxX; ++cellX )
+		{
+			auto found = m_cells.find( MakeCellKey( cellX, cellY ) );
+			if( found != m_cells.end() )
+			{
+				out.insert( out.end(), found->second.begin(), found->second.end() );
+			}
+		}
+	}
+
+	out.insert( out.end(), m_oversized.begin(), m_oversized.end() );
+
+	// Big triggers sit in several cells
+	std::sort( out.begin() + firstOut, out.end() );
+	out.erase( std::unique( out.begin() + firstOut, out.end() ), out.end() );
+}
+
+//--------------------------------------------------------------------------
+/**
+* GetCellCoord
+* Clamped so far-off points can't overflow the key.
+*/
+int TriggerField::GetCellCoord( float value ) const
+{
+	float cell = floorf( value / m_cellSize );
+	cell = std::max( std::min( cell, 1.0e9f ), -1.0e9f );
+	return (int) cell;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "Game/TriggerDefinition.hpp"
+#include "Game/GameCommon.hpp"
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+//--------------------------------------------------------------------------
+// The map's trigger volumes, filed in a uniform hash grid. Unlike ShapeGrid a
+// trigger is filed in every cell its circle overlaps, so a point only ever
+// needs its own cell. Triggers too big to file that way are tested against
+// every point instead. Triggers don't move; the field is rebuilt when the set changes.
+//--------------------------------------------------------------------------
+class TriggerField
+{
+public:
+	explicit TriggerField( float cellSize = 8.0f );
+
+	void Build( const TriggerDefinition* triggers, uint count );
+	void Clear();
+
+	void GatherAt( const Vec2& point, std::vector<uint>& out ) const;
+	void GatherBox( const Vec2& mins, const Vec2& maxs, std::vector<uint>& out ) const;
+
+	uint GetCount() const								{ return (uint) m_triggers.size(); }
+	const TriggerDefinition& GetTrigger( uint triggerIdx ) const	{ return m_triggers[triggerIdx]; }
+
+private:
+	int GetCellCoord( float value ) const;
+
+private:
+	float m_cellSize;
+	std::vector<TriggerDefinition> m_triggers;
+	std::unordered_map<uint64_t, std::vector<uint>> m_cells;
+	std::vector<uint> m_oversized;
+};